@@ -48,8 +48,31 @@ SOFTWARE.
  *  $CC -c -std=c99 open62541.c
  *  $CXX -c -std=gnu++11 -I. -L$SDKTARGETSYSROOT/opt/libera/lib libera_mci.cpp
  *  $CC -c -std=c99 -I. libera_opcua.c
+ *  $CC -c -std=c99 -I. pulse_calibration.c
+ *  $CC -c -std=c99 -I. pulse_position.c
+ *  $CC -c -std=c99 -I. auto_attenuation.c
+ *  $CC -c -std=c99 -I. adaptive_threshold.c
+ *  $CC -c -std=c99 -I. pulse_median.c
+ *  $CC -c -std=c99 -I. pulse_quantile.c
+ *  $CC -c -std=c99 -I. pulse_topk.c
+ *  $CC -c -std=c99 -I. pulse_burst.c
+ *  $CC -c -std=c99 -I. pulse_expression.c
+ *  $CC -c -std=c99 -I. pulse_alarm.c
+ *  $CC -c -std=c99 -I. pulse_coincidence.c
+ *  $CC -c -std=c99 -I. pulse_rate.c
+ *  $CC -c -std=c99 -I. device_clock.c
+ *  $CC -c -std=c99 -I. pulse_trigger.c
+ *  $CC -c -std=c99 -I. pulse_trend.c
+ *  $CC -c -std=c99 -I. pulse_change.c
+ *  $CC -c -std=c99 -I. pulse_type.c
+ *  $CC -c -std=c99 -I. pulse_snapshot.c
+ *  $CC -c -std=c99 -I. pulse_history.c
+ *  $CC -c -std=c99 -I. pulse_push.c
+ *  $CC -c -std=c99 -I. pulse_event.c
+ *  $CC -c -std=c99 -I. pulse_hdb.c
+ *  $CC -c -std=c99 -I. pulse_archive.c
  *  $CC -c -std=c99 -I. OpcUaServer.c
- *  $CXX -o opcua_server OpcUaServer.o open62541.o libera_mci.o libera_opcua.o  -lpthread -L$SDKTARGETSYSROOT/opt/libera/lib -lliberamci -lliberaisig -lliberaistd -lliberainet -lomniORB4 -lomniDynamic4 -lomnithread
+ *  $CXX -o opcua_server OpcUaServer.o open62541.o libera_mci.o libera_opcua.o pulse_calibration.o pulse_position.o auto_attenuation.o adaptive_threshold.o pulse_median.o pulse_quantile.o pulse_topk.o pulse_burst.o pulse_expression.o pulse_alarm.o pulse_coincidence.o pulse_rate.o device_clock.o pulse_trigger.o pulse_trend.o pulse_change.o pulse_type.o pulse_snapshot.o pulse_history.o pulse_push.o pulse_event.o pulse_hdb.o pulse_archive.o -lpthread -L$SDKTARGETSYSROOT/opt/libera/lib -lliberamci -lliberaisig -lliberaistd -lliberainet -lomniORB4 -lomniDynamic4 -lomnithread
  *
  *
  *  @section Testing
@@ -57,6 +80,8 @@ SOFTWARE.
  *  [UaExpert](https://www.unified-automation.com/products/development-tools/uaexpert.html) is recommended.
  */
 
+#define _DEFAULT_SOURCE                  // for clock_gettime() with -std=c99
+
 #include <unistd.h>
 #include <stdio.h>
 #include <signal.h>		     // for signal()
@@ -64,9 +89,35 @@ SOFTWARE.
 #include <fcntl.h>
 #include <sys/stat.h>        // for fstat()
 #include <pthread.h>         // for threads
+#include <poll.h>            // for poll()
+#include <time.h>            // for clock_gettime()
 
 #include "open62541.h"       // the OPC-UA library
 #include "libera_opcua.h"
+#include "pulse_data.h"
+#include "pulse_calibration.h"
+#include "pulse_position.h"
+#include "auto_attenuation.h"
+#include "adaptive_threshold.h"
+#include "pulse_median.h"
+#include "pulse_quantile.h"
+#include "pulse_topk.h"
+#include "pulse_burst.h"
+#include "pulse_expression.h"
+#include "pulse_alarm.h"
+#include "pulse_coincidence.h"
+#include "pulse_rate.h"
+#include "device_clock.h"
+#include "pulse_trigger.h"
+#include "pulse_trend.h"
+#include "pulse_change.h"
+#include "pulse_type.h"
+#include "pulse_snapshot.h"
+#include "pulse_history.h"
+#include "pulse_push.h"
+#include "pulse_event.h"
+#include "pulse_hdb.h"
+#include "pulse_archive.h"
 
 /***********************************/
 /* Server-related variables        */
@@ -101,45 +152,113 @@ static void stopHandler(int signal)
 /* data stream extracted variables */
 /***********************************/
 
-// the data structure sent by the Libera instrument
-typedef struct {
-   int32_t Ch1_rss;
-   int32_t Ch1_peak;
-   int32_t Ch1_avg;
-   int32_t Ch1_sum;
-   int32_t Ch2_rss;
-   int32_t Ch2_peak;
-   int32_t Ch2_avg;
-   int32_t Ch2_sum;
-   int32_t Ch3_rss;
-   int32_t Ch3_peak;
-   int32_t Ch3_avg;
-   int32_t Ch3_sum;
-   int32_t Ch4_rss;
-   int32_t Ch4_peak;
-   int32_t Ch4_avg;
-   int32_t Ch4_sum;
-} pulse_data;
-#define BLOCKSIZE 64
-
-// This is the last received data block from the stream.
-// It is written asynchronously by the receiver thread.
-// While the thread is writing the block the according semaphore is set.
-static volatile pulse_data stream_data_block;
-static volatile bool stream_data_block_writing_active = false;
+// maximum number of data blocks collected into one batch for processing
+#define BATCH_BLOCKS 32
+
+// The last accepted data block, its flags and calibrated values and the pulse rate
+// are published to the stream snapshot (pulse_snapshot.h) served by the server.
 static volatile int32_t pulse_counter = 0;
 static volatile int32_t pulse_stream_pps = 0;
 
+// the batch converted into physical units, available to all processing stages
+static pulse_data_calibrated calibrated_batch[BATCH_BLOCKS];
+// the beam positions of the batch
+static pulse_position position_batch[BATCH_BLOCKS];
+// the states of the blocks for the snapshot, the push updates and the history database
+static pulse_snapshot batch_states[BATCH_BLOCKS];
+// Remove all blocks carrying any of the reject flags
+// or missing any of the required flags from the batch.
+// Returns the number of remaining blocks.
+static int compact_batch(pulse_data *blocks, pulse_info *info, int count, uint32_t reject, uint32_t require)
+{
+    int n = 0;
+    for (int k=0; k<count; k++)
+    {
+        if (info[k].flags & reject) continue;
+        if ((info[k].flags & require) != require) continue;
+        if (n != k)
+        {
+            blocks[n] = blocks[k];
+            info[n] = info[k];
+        }
+        n++;
+    }
+    return n;
+}
+
+// The processing stages for the blocks passing the outlier rejection
+// and the coincidence filter.
+static void process_accepted(pulse_data *blocks, pulse_info *info, int count)
+{
+    calibration_apply(blocks, calibrated_batch, count);
+    position_process(blocks, position_batch, count);
+    for (int k=0; k<count; k++)
+        snapshot_fill(&batch_states[k], &blocks[k], &info[k], &calibrated_batch[k], &position_batch[k], pulse_stream_pps);
+    snapshot_publish(&batch_states[count-1]);
+    history_process(blocks, info, count);
+    push_process(batch_states, count);
+    event_process(blocks, info, count, true);
+    quantile_process(blocks, count);
+    topk_process(blocks, info, count);
+    burst_process(blocks, info, count);
+    expression_process(blocks, count);
+    trend_process(blocks, info, count);
+    change_process(blocks, info, count);
+    // after all stages, the results of this batch are recorded with the pulses
+    hdb_process(batch_states, count);
+    archive_process(batch_states, count);
+}
+
+// All processing stages are applied to a batch of consecutive data blocks.
+// This is called by the receiver thread whenever a batch is complete.
+// Blocks rejected by a stage are removed before the following stages.
+static void process_pulse_batch(pulse_data *blocks, pulse_info *info, int count)
+{
+    trigger_process(info, count);
+    autorange_process(blocks, info, count);
+    // the noise floor is estimated from the raw stream, before any block is rejected
+    threshold_process(blocks, count);
+    median_process(blocks, info, count);
+    // the limits are checked on every ingested block, also on the rejected ones
+    alarm_process(blocks, info, count);
+    event_process(blocks, info, count, false);
+    if (median_mode == MEDIAN_MODE_REJECT)
+    {
+        int n = compact_batch(blocks, info, count, PULSE_FLAG_OUTLIER, 0);
+        median_rejected += count - n;
+        count = n;
+        if (count == 0) return;
+    }
+    // with the filter enabled the coincident blocks are released from the hold queue
+    // once their mark is final, the batch buffer is reused for them
+    if (coincidence_process(blocks, info, count))
+    {
+        while ((count = coincidence_release(blocks, info, BATCH_BLOCKS)) > 0)
+            process_accepted(blocks, info, count);
+        return;
+    }
+    process_accepted(blocks, info, count);
+}
+
 // Read the data from the pulse-processing stream and write into the global data block.
 // This procedure will be forked off as a parallel thread.
 // It needs the file descriptor of the open stream as a parameter.
 // It runs until the OPC UA server is stopped.
+// The blocks are collected into a batch as long as more data is immediately
+// available from the stream. The batch is handed to the processing stages
+// when it is full or the stream runs empty.
 void* read_pulse_Stream(void *arg)
 {
     char readbuffer[BLOCKSIZE];             // buffer for reading from the data stream
+    pulse_data batch[BATCH_BLOCKS];         // blocks waiting for processing
+    pulse_info batch_info[BATCH_BLOCKS];    // sequence number, time and flags of the blocks
+    int batch_count = 0;
+    uint64_t sequence = 0;
+    struct timespec now;
     
     int fd = *((int *)arg);
     printf("OpcUaServer : reading from fd=%d\n",fd);
+    struct pollfd pending = { .fd = fd, .events = POLLIN };
 
     while (running)
     {
@@ -154,11 +273,20 @@ void* read_pulse_Stream(void *arg)
         // handle proper data blocks
         if (BLOCKSIZE==bytes_read)
         {
-            stream_data_block_writing_active = true;
             pulse_counter++;
-            // copy data from buffer to struct
-            memcpy((void *) &stream_data_block, readbuffer, BLOCKSIZE);
-            stream_data_block_writing_active = false;
+            clock_gettime(CLOCK_REALTIME, &now);
+            batch_info[batch_count].sequence = sequence++;
+            batch_info[batch_count].timestamp = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+            batch_info[batch_count].flags = 0;
+            batch_info[batch_count].trigger = 0;
+            batch_info[batch_count].trigger_offset = 0;
+            memcpy(&batch[batch_count++], readbuffer, BLOCKSIZE);
+        };
+        // process the batch if it is full or no more data are waiting
+        if ((batch_count == BATCH_BLOCKS) || ((batch_count > 0) && (poll(&pending, 1, 0) <= 0)))
+        {
+            process_pulse_batch(batch, batch_info, batch_count);
+            batch_count = 0;
         };
     };
     printf("OpcUaServer : read thread exit\n");
@@ -171,10 +299,19 @@ void* timer_thread(void* arg) {
     (void)arg;  // Unused parameter
     while (running) {
         sleep(1.0);
-        stream_data_block_writing_active = true;
         pulse_stream_pps = pulse_counter;
         pulse_counter = 0;
-        stream_data_block_writing_active = false;
+        snapshot_publish_pps(pulse_stream_pps);
+        calibration_update();
+        threshold_update(pulse_stream_pps);
+        rate_update(pulse_stream_pps);
+        quantile_update();
+        topk_update();
+        burst_update();
+        coincidence_update();
+        clock_update();
+        trend_update(pulse_stream_pps);
+        archive_update();
     }
     printf("OpcUaServer : timer thread exit\n");
     pthread_exit(NULL);
@@ -194,9 +331,9 @@ static UA_StatusCode read_UA_Int32(
     const UA_NumericRange *range,
     UA_DataValue *dataValue)
 {
-    // wait for semaphore because
     // this read method is mainly used for data stream related variables
-    while (stream_data_block_writing_active);
+    // which are served from the snapshot of the current main loop iteration
+    snapshot_take();
     UA_Variant_setScalarCopy(&dataValue->value, (UA_Int32*)nodeContext, &UA_TYPES[UA_TYPES_INT32]);
     dataValue->hasValue = true;
     return UA_STATUSCODE_GOOD;
@@ -216,6 +353,98 @@ static UA_StatusCode write_UA_Int32(
     return UA_STATUSCODE_GOOD;
 }
 
+static UA_StatusCode read_UA_UInt32(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    // this read method is mainly used for data stream related variables
+    // which are served from the snapshot of the current main loop iteration
+    snapshot_take();
+    UA_Variant_setScalarCopy(&dataValue->value, (UA_UInt32*)nodeContext, &UA_TYPES[UA_TYPES_UINT32]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode read_UA_UInt64(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    // this read method is mainly used for data stream related variables
+    // which are served from the snapshot of the current main loop iteration
+    snapshot_take();
+    UA_Variant_setScalarCopy(&dataValue->value, (UA_UInt64*)nodeContext, &UA_TYPES[UA_TYPES_UINT64]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode read_UA_Float(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    // this read method is mainly used for data stream related variables
+    // which are served from the snapshot of the current main loop iteration
+    snapshot_take();
+    UA_Variant_setScalarCopy(&dataValue->value, (UA_Float*)nodeContext, &UA_TYPES[UA_TYPES_FLOAT]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode read_UA_Double(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    // this read method is mainly used for data stream related variables
+    // which are served from the snapshot of the current main loop iteration
+    snapshot_take();
+    UA_Variant_setScalarCopy(&dataValue->value, (UA_Double*)nodeContext, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode write_UA_Float(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    const UA_NumericRange *range,
+    const UA_DataValue *data)
+{
+    if (UA_Variant_isScalar(&(data->value)) && data->value.type == &UA_TYPES[UA_TYPES_FLOAT] && data->value.data)
+    {
+        *(UA_Float*)nodeContext = *(UA_Float*)data->value.data;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_StatusCode write_UA_Double(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    const UA_NumericRange *range,
+    const UA_DataValue *data)
+{
+    if (UA_Variant_isScalar(&(data->value)) && data->value.type == &UA_TYPES[UA_TYPES_DOUBLE] && data->value.data)
+    {
+        *(UA_Double*)nodeContext = *(UA_Double*)data->value.data;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
 /***********************************/
 /* main program                    */
 /***********************************/
@@ -240,6 +469,15 @@ int main(int argc, char** argv)
         // printf("UA_ServerConfig_setMinimal() error %8x\n", res);
         exit(-1);
     }
+    // the structured data type of the pulse data
+    config.customDataTypes = &pulse_types;
+    // allow monitored item queues holding all blocks of the lossless push mode
+    config.queueSizeLimits.max = PUSH_QUEUE;
+    // the history of the push variables is kept in memory
+    config.historyDatabase = hdb_database();
+    config.accessHistoryDataCapability = true;
+    // the pulse events are only created while they are monitored
+    config.monitoredItemRegisterCallback = event_monitored_item;
     server = UA_Server_newWithConfig(&config);
     if(!server)
     {
@@ -251,6 +489,9 @@ int main(int argc, char** argv)
     // capture the pulse data stream
     //**************************************
 
+    // map the trend store before any data arrive
+    trend_open(TREND_FILE);
+
     // open the data stream
     int stream_fd = open("/dev/libera.strm0", O_RDONLY);
     if (stream_fd == -1)
@@ -274,6 +515,20 @@ int main(int argc, char** argv)
     else
         printf("OpcUaServer : timer thread created successfully\n");
 
+    // fork off a thread for the automatic attenuation
+    pthread_t autorange_tid;
+    if (0 != pthread_create(&autorange_tid, NULL, autorange_thread, NULL))
+        Die("OpcUaServer : failed to create auto-ranging thread");
+    else
+        printf("OpcUaServer : auto-ranging thread created successfully\n");
+
+    // fork off a thread following the t2 triggers
+    pthread_t trigger_tid;
+    if (0 != pthread_create(&trigger_tid, NULL, trigger_thread, NULL))
+        Die("OpcUaServer : failed to create trigger thread");
+    else
+        printf("OpcUaServer : trigger thread created successfully\n");
+
     //**************************************
     // create and populate the device folder
     // code by code_generator.py
@@ -287,13 +542,39 @@ int main(int argc, char** argv)
     //**************************************
     // add manually coded variables
     //**************************************
+
+    topk_add_method(server, Top_pulsesFolder);
+    alarm_add_events(server);
+    change_add_events(server);
+    event_add_events(server);
+    pulse_type_add(server, Pulse_acquisitionFolder);
+    push_start(server);
+
+    // load the index of the archive segments
+    // rows are recorded from now on, with all archived variables registered
+    archive_open(ARCHIVE_DIR);
     
     // run the server (forever unless stopped with ctrl-C)
-    UA_StatusCode retval = UA_Server_run(server, &running);
-    
-    // the server has stopped running
+    // The main loop is run explicitly to renew the stream snapshot
+    // before every iteration. All stream variables read while processing
+    // one request or sampling the monitored items belong to the same block.
+    UA_StatusCode retval = UA_Server_run_startup(server);
     if(retval != UA_STATUSCODE_GOOD)
-        printf("UA_Server_run() error %8x\n", retval);
+        printf("UA_Server_run_startup() error %8x\n", retval);
+    else
+    {
+        while (running)
+        {
+            snapshot_invalidate();
+            history_invalidate();
+            burst_invalidate();
+            UA_Server_run_iterate(server, true);
+        }
+        retval = UA_Server_run_shutdown(server);
+        // the server has stopped running
+        if(retval != UA_STATUSCODE_GOOD)
+            printf("UA_Server_run_shutdown() error %8x\n", retval);
+    }
     UA_LOG_INFO(UA_Log_Stdout, UA_LOGCATEGORY_SERVER, "server stopped running.");
     UA_Server_delete(server);
     // nl.deleteMembers(&nl);
@@ -301,6 +582,12 @@ int main(int argc, char** argv)
     // wait for the read and timer threads to exit
     pthread_join(stream_tid, NULL);
     pthread_join(timer_tid, NULL);
+    autorange_stop();
+    pthread_join(autorange_tid, NULL);
+    trigger_stop();
+    pthread_join(trigger_tid, NULL);
+    trend_close();
+    archive_close();
 
     int status = close(stream_fd);
     if (-1==status)
@@ -0,0 +1,189 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file adaptive_threshold.c
+  OpcUaServer : adaptive pulse-processing threshold
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "libera_mci.h"      // the MCI access layer
+#include "adaptive_threshold.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t threshold_auto_enable = 0;
+float threshold_k = 5.0f;
+float threshold_low_factor = 2.0f;
+int32_t threshold_tau = 1000;
+int32_t threshold_min = 10;
+int32_t threshold_max = 4000;
+int32_t threshold_target_rate = 10000;
+int32_t threshold_rate_step = 5;
+int32_t threshold_deadband = 2;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+float threshold_baseline[PULSE_CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+float threshold_noise[PULSE_CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+int32_t threshold_estimate = 0;
+int32_t threshold_current = 0;
+int32_t threshold_rate = 0;
+int32_t threshold_changes = 0;
+
+/***********************************/
+/* noise statistics                */
+/***********************************/
+
+// exponentially weighted averages per channel
+// the first pulse initializes the baseline
+typedef struct {
+    bool valid;
+    double baseline;            // mean of avg
+    double baseline_var;        // variance of avg
+    double excursion_sq;        // mean square excursion of low-amplitude pulses
+    bool excursion_valid;
+} noise_state;
+
+static noise_state noise[PULSE_CHANNELS];
+
+// correction of the threshold by the rate control
+static int32_t rate_offset = 0;
+
+// the statistics are written by the stream reader thread and read by the timer thread
+static pthread_mutex_t threshold_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void threshold_process(const pulse_data *blocks, int count)
+{
+    double alpha = 1.0 / ((threshold_tau > 1) ? threshold_tau : 1);
+    double low_cut = threshold_low_factor * (double)threshold_current;
+
+    pthread_mutex_lock(&threshold_lock);
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        noise_state *n = &noise[ch];
+        for (int k=0; k<count; k++)
+        {
+            double avg = PULSE_VALUE(&blocks[k], ch, FIELD_AVG);
+            double peak = PULSE_VALUE(&blocks[k], ch, FIELD_PEAK);
+            if (!n->valid)
+            {
+                n->baseline = avg;
+                n->baseline_var = 0.0;
+                n->valid = true;
+            }
+            double d = avg - n->baseline;
+            n->baseline += alpha * d;
+            n->baseline_var = (1.0 - alpha) * (n->baseline_var + alpha * d * d);
+            double excursion = fabs(peak - avg);
+            if ((low_cut <= 0.0) || (excursion < low_cut))
+            {
+                if (!n->excursion_valid)
+                {
+                    n->excursion_sq = excursion * excursion;
+                    n->excursion_valid = true;
+                }
+                else
+                    n->excursion_sq += alpha * (excursion * excursion - n->excursion_sq);
+            }
+        }
+    }
+    pthread_mutex_unlock(&threshold_lock);
+}
+
+void threshold_update(int32_t pps)
+{
+    threshold_rate = pps;
+
+    // noise floor estimate - the largest of all channels
+    bool valid = false;
+    double estimate = 0.0;
+    pthread_mutex_lock(&threshold_lock);
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        noise_state *n = &noise[ch];
+        if (!n->valid) continue;
+        double var = n->baseline_var;
+        if (n->excursion_valid && (n->excursion_sq > var)) var = n->excursion_sq;
+        double sigma = sqrt(var);
+        threshold_baseline[ch] = (float)n->baseline;
+        threshold_noise[ch] = (float)sigma;
+        double t = n->baseline + threshold_k * sigma;
+        if (!valid || (t > estimate)) estimate = t;
+        valid = true;
+    }
+    pthread_mutex_unlock(&threshold_lock);
+    if (!valid) return;
+
+    // the rate control raises the threshold as long as the rate is too high
+    // and releases the correction when the rate has dropped to half the target
+    if (pps > threshold_target_rate)
+        rate_offset += threshold_rate_step;
+    else if ((pps < threshold_target_rate / 2) && (rate_offset > 0))
+    {
+        rate_offset -= threshold_rate_step;
+        if (rate_offset < 0) rate_offset = 0;
+    }
+
+    int32_t t = (int32_t)lround(estimate) + rate_offset;
+    if (t > threshold_max)
+    {
+        t = threshold_max;
+        // do not let the correction wind up beyond the limit
+        rate_offset = t - (int32_t)lround(estimate);
+        if (rate_offset < 0) rate_offset = 0;
+    }
+    if (t < threshold_min) t = threshold_min;
+    threshold_estimate = t;
+
+    // the current setting is needed for the selection of low-amplitude pulses
+    // even if the threshold is not controlled by the server
+    int32_t current;
+    if (!mci_get_pulse_threshold(&current))
+    {
+        printf("MCI value error : get : application.dsp.pulse_processing.threshold\n");
+        return;
+    }
+    threshold_current = current;
+    if (!threshold_auto_enable) return;
+    if (abs(t - current) >= threshold_deadband)
+    {
+        if (mci_set_pulse_threshold(t))
+        {
+            threshold_current = t;
+            threshold_changes++;
+        }
+        else
+            printf("MCI value error : set : application.dsp.pulse_processing.threshold\n");
+    }
+}
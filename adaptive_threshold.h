@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file adaptive_threshold.h
+  OpcUaServer : adaptive pulse-processing threshold
+  Version 0.2 2026/10/19
+
+  The noise floor of every channel is estimated from every ingested block,
+  before the outlier rejection and the coincidence filter.
+  The baseline is the running mean of Ch*_avg. The noise amplitude
+  is the rms of the baseline fluctuations combined with the rms excursion
+  (peak - avg) of low-amplitude pulses, i.e. pulses with an excursion
+  below threshold_low_factor times the current threshold.
+  All averages are exponentially weighted with a time constant
+  of threshold_tau pulses.
+
+  Once every second the threshold is estimated as
+    baseline + threshold_k * sigma
+  (largest value of all channels) plus a correction keeping the trigger
+  rate below threshold_target_rate. If enabled, the threshold is set
+  over MCI when the estimate differs by more than threshold_deadband
+  from the current setting. The result is limited to the configured bounds.
+ */
+
+#include <stdint.h>
+
+#ifndef ADAPTIVETHRESHOLD_H
+#define ADAPTIVETHRESHOLD_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t threshold_auto_enable;   // 0=estimate only 1=set the threshold
+extern float threshold_k;               // threshold in units of the noise sigma
+extern float threshold_low_factor;      // low-amplitude pulses relative to the threshold
+extern int32_t threshold_tau;           // averaging time constant [pulses]
+extern int32_t threshold_min;           // limits of the threshold [ADC counts]
+extern int32_t threshold_max;
+extern int32_t threshold_target_rate;   // maximum trigger rate [pulses/s]
+extern int32_t threshold_rate_step;     // rate correction step [ADC counts]
+extern int32_t threshold_deadband;      // minimum change of the threshold [ADC counts]
+
+//*************************************
+// results
+//*************************************
+
+extern float threshold_baseline[PULSE_CHANNELS];
+extern float threshold_noise[PULSE_CHANNELS];
+extern int32_t threshold_estimate;      // the resulting threshold estimate
+extern int32_t threshold_current;       // the threshold set in the instrument
+extern int32_t threshold_rate;          // trigger rate at the last update [pulses/s]
+extern int32_t threshold_changes;       // number of threshold changes
+
+// update the noise statistics with a batch of data blocks
+void threshold_process(const pulse_data *blocks, int count);
+
+// to be called once every second from the timer thread with the measured pulse rate
+// computes the estimate and sets the threshold if enabled
+void threshold_update(int32_t pps);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,259 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file auto_attenuation.c
+  OpcUaServer : automatic attenuation (auto-ranging)
+  Version 0.2 2026/10/19
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libera_mci.h"      // the MCI access layer
+#include "pulse_calibration.h"
+#include "auto_attenuation.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t autorange_enable = 0;
+int32_t autorange_clip = 8100;
+int32_t autorange_high = 6000;
+int32_t autorange_low = 1500;
+int32_t autorange_window = 100;
+int32_t autorange_step = 2;
+int32_t autorange_att_min = 0;
+int32_t autorange_att_max = 31;
+int32_t autorange_holdoff = 20;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+int32_t autorange_attenuation[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t autorange_changes[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t autorange_clipped[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+
+/***********************************/
+/* control loop state              */
+/***********************************/
+
+typedef struct {
+    int32_t count;                  // pulses evaluated in the current window
+    int32_t max_peak;               // largest peak in the current window
+    int32_t clipped;                // clipped pulses in the current window
+    int32_t request;                // requested change in steps, 0 if none pending
+    bool busy;                      // change requested or hold-off running
+    struct timespec holdoff_end;    // end of the hold-off after the change was written
+} channel_state;
+
+static channel_state channel[PULSE_CHANNELS];
+
+// the channel state is shared between the stream reader and the control thread
+static pthread_mutex_t autorange_lock = PTHREAD_MUTEX_INITIALIZER;
+static pthread_cond_t autorange_cond = PTHREAD_COND_INITIALIZER;
+static bool autorange_running = true;
+
+static bool time_reached(const struct timespec *now, const struct timespec *t)
+{
+    return (now->tv_sec > t->tv_sec) || ((now->tv_sec == t->tv_sec) && (now->tv_nsec >= t->tv_nsec));
+}
+
+static void reset_window(channel_state *c)
+{
+    c->count = 0;
+    c->max_peak = 0;
+    c->clipped = 0;
+}
+
+/***********************************/
+/* stream processing               */
+/***********************************/
+
+void autorange_process(const pulse_data *blocks, pulse_info *info, int count)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    bool enable = (autorange_enable != 0);
+    int32_t clip = autorange_clip;
+    int32_t high = autorange_high;
+    int32_t low = autorange_low;
+    int32_t window = (autorange_window > 0) ? autorange_window : 1;
+    bool wakeup = false;
+
+    pthread_mutex_lock(&autorange_lock);
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        channel_state *c = &channel[ch];
+        // the hold-off ends after the change has been written and the time has expired
+        if (c->busy && (c->request == 0) && time_reached(&now, &c->holdoff_end))
+        {
+            c->busy = false;
+            reset_window(c);
+        }
+        for (int k=0; k<count; k++)
+        {
+            int32_t peak = PULSE_VALUE(&blocks[k], ch, FIELD_PEAK);
+            if (peak < 0) peak = -peak;
+            if (peak >= clip)
+            {
+                info[k].flags |= (PULSE_FLAG_CLIPPED_CH1 << ch);
+                autorange_clipped[ch]++;
+            }
+            if (c->busy)
+            {
+                info[k].flags |= PULSE_FLAG_RANGING;
+                continue;
+            }
+            c->count++;
+            if (peak > c->max_peak) c->max_peak = peak;
+            if (peak >= clip) c->clipped++;
+            if (c->count >= window)
+            {
+                int32_t request = 0;
+                if ((c->clipped > 0) || (c->max_peak > high))
+                    request = 1;
+                else if (c->max_peak < low)
+                    request = -1;
+                if (enable && (request != 0))
+                {
+                    c->request = request;
+                    c->busy = true;
+                    wakeup = true;
+                }
+                reset_window(c);
+            }
+        }
+    }
+    if (wakeup) pthread_cond_signal(&autorange_cond);
+    pthread_mutex_unlock(&autorange_lock);
+}
+
+/***********************************/
+/* control thread                  */
+/***********************************/
+
+static bool get_attenuation(int ch, uint32_t *val)
+{
+    switch (ch)
+    {
+        case 0: return mci_get_attenuation_ch1(val);
+        case 1: return mci_get_attenuation_ch2(val);
+        case 2: return mci_get_attenuation_ch3(val);
+        case 3: return mci_get_attenuation_ch4(val);
+    }
+    return false;
+}
+
+static bool set_attenuation(int ch, uint32_t val)
+{
+    switch (ch)
+    {
+        case 0: return mci_set_attenuation_ch1(val);
+        case 1: return mci_set_attenuation_ch2(val);
+        case 2: return mci_set_attenuation_ch3(val);
+        case 3: return mci_set_attenuation_ch4(val);
+    }
+    return false;
+}
+
+// Wait for change requests from the stream processing and write
+// the new attenuation over MCI. The hold-off of the channel starts
+// when the write has completed.
+void* autorange_thread(void *arg)
+{
+    (void)arg;  // Unused parameter
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        uint32_t att;
+        if (get_attenuation(ch, &att))
+            autorange_attenuation[ch] = att;
+    }
+
+    pthread_mutex_lock(&autorange_lock);
+    while (autorange_running)
+    {
+        int ch = 0;
+        while ((ch < PULSE_CHANNELS) && (channel[ch].request == 0)) ch++;
+        if (ch == PULSE_CHANNELS)
+        {
+            pthread_cond_wait(&autorange_cond, &autorange_lock);
+            continue;
+        }
+        int32_t change = channel[ch].request * autorange_step;
+        pthread_mutex_unlock(&autorange_lock);
+
+        uint32_t att;
+        bool success = get_attenuation(ch, &att);
+        if (success)
+        {
+            int32_t new_att = (int32_t)att + change;
+            if (new_att > autorange_att_max) new_att = autorange_att_max;
+            if (new_att < autorange_att_min) new_att = autorange_att_min;
+            if (new_att != (int32_t)att)
+            {
+                success = set_attenuation(ch, (uint32_t)new_att);
+                if (success)
+                {
+                    autorange_changes[ch]++;
+                    calibration_invalidate();
+                    printf("OpcUaServer : attenuation Ch%d set to %d\n", ch+1, new_att);
+                }
+            }
+            if (success) autorange_attenuation[ch] = new_att;
+        }
+        if (!success)
+            printf("MCI value error : auto-ranging Ch%d\n", ch+1);
+
+        struct timespec now;
+        clock_gettime(CLOCK_MONOTONIC, &now);
+        int32_t holdoff = (autorange_holdoff > 0) ? autorange_holdoff : 0;
+        pthread_mutex_lock(&autorange_lock);
+        channel[ch].request = 0;
+        channel[ch].holdoff_end.tv_sec = now.tv_sec + holdoff / 1000;
+        channel[ch].holdoff_end.tv_nsec = now.tv_nsec + (holdoff % 1000) * 1000000L;
+        if (channel[ch].holdoff_end.tv_nsec >= 1000000000L)
+        {
+            channel[ch].holdoff_end.tv_sec++;
+            channel[ch].holdoff_end.tv_nsec -= 1000000000L;
+        }
+    }
+    pthread_mutex_unlock(&autorange_lock);
+    printf("OpcUaServer : auto-ranging thread exit\n");
+    pthread_exit(NULL);
+}
+
+void autorange_stop()
+{
+    pthread_mutex_lock(&autorange_lock);
+    autorange_running = false;
+    pthread_cond_broadcast(&autorange_cond);
+    pthread_mutex_unlock(&autorange_lock);
+}
@@ -0,0 +1,91 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file auto_attenuation.h
+  OpcUaServer : automatic attenuation (auto-ranging)
+  Version 0.2 2026/10/19
+
+  The peak values of every channel are watched over a window of pulses.
+  If any pulse reaches the clipping level or the largest peak exceeds
+  the upper level the attenuation is increased by one step.
+  If the largest peak stays below the lower level the attenuation is decreased.
+  The gap between the levels provides the hysteresis, it has to be larger
+  than one attenuation step. After every change the channel is held off
+  for a configurable time, pulses in that period are marked PULSE_FLAG_RANGING.
+
+  The decision is taken in the stream reader thread, the MCI write is done
+  by a separate control thread so the stream is never blocked by MCI calls.
+ */
+
+#include <stdint.h>
+
+#ifndef AUTOATTENUATION_H
+#define AUTOATTENUATION_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t autorange_enable;        // 0=off 1=on
+extern int32_t autorange_clip;          // peak value [ADC counts] regarded as clipping
+extern int32_t autorange_high;          // upper level [ADC counts]
+extern int32_t autorange_low;           // lower level [ADC counts]
+extern int32_t autorange_window;        // number of pulses evaluated for a decision
+extern int32_t autorange_step;          // attenuation step [dB]
+extern int32_t autorange_att_min;       // attenuation range [dB]
+extern int32_t autorange_att_max;
+extern int32_t autorange_holdoff;       // minimum time between changes [ms]
+
+//*************************************
+// results
+//*************************************
+
+// attenuation last set by the control loop
+extern int32_t autorange_attenuation[PULSE_CHANNELS];
+// number of attenuation changes
+extern int32_t autorange_changes[PULSE_CHANNELS];
+// number of clipped pulses
+extern int32_t autorange_clipped[PULSE_CHANNELS];
+
+// watch the peaks of a batch of data blocks and request attenuation changes
+// clipped pulses and pulses during an attenuation change are flagged
+void autorange_process(const pulse_data *blocks, pulse_info *info, int count);
+
+// the control thread writing the attenuation settings
+// it runs until autorange_stop() is called
+void* autorange_thread(void *arg);
+void autorange_stop();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
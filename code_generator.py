@@ -33,13 +33,17 @@ class Node(dict):
         code = f'''bool mci_get_{self['function']}({self['mci_type']} *val)\n'''
         code += '{\n'
         code += f'''    {self['mci_type']} mci_val;\n'''
+        code += f'''    pthread_mutex_lock(&mci_lock);\n'''
         code += f'''    bool success = node_{self['function']}.GetValue(mci_val);\n'''
+        code += f'''    pthread_mutex_unlock(&mci_lock);\n'''
         code += f'''    *val = mci_val;\n'''
         code += f'''    return success;\n'''
         code += '}\n'
         code += f'''bool mci_set_{self['function']}({self['mci_type']} val)\n'''
         code += '{\n'
+        code += f'''    pthread_mutex_lock(&mci_lock);\n'''
         code += f'''    bool success = node_{self['function']}.SetValue(val);\n'''
+        code += f'''    pthread_mutex_unlock(&mci_lock);\n'''
         code += f'''    return success;\n'''
         code += '}\n'
         return code
@@ -105,7 +109,13 @@ class Node(dict):
         code += '''    {\n'''
         code += f'''        {self['mci_type']} val = *({self['mci_type']}*)data->value.data;\n'''
         code += f'''        if(mci_set_{self['function']}(val))\n'''
-        code += f'''            return UA_STATUSCODE_GOOD;\n'''
+        if 'on_change' in self.keys():
+            code += '''        {\n'''
+            code += f'''            {self['on_change']}();\n'''
+            code += f'''            return UA_STATUSCODE_GOOD;\n'''
+            code += '''        }\n'''
+        else:
+            code += f'''            return UA_STATUSCODE_GOOD;\n'''
         code += f'''        else\n'''
         code += '''        {\n'''
         code += f'''            printf("MCI value error : set : {self['token_string']}\\n");\n'''
@@ -124,7 +134,9 @@ class Node(dict):
         code += f'''    attr.description = UA_LOCALIZEDTEXT("en_US","{self['description']}");\n'''
         code += f'''    attr.displayName = UA_LOCALIZEDTEXT("en_US","{self['name']}");\n'''
         code += f'''	attr.valueRank = UA_VALUERANK_SCALAR;\n'''
-        code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;\n'''
+        # the settings of the device are archived, their history is read from the archive
+        code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE | UA_ACCESSLEVELMASK_HISTORYREAD;\n'''
+        code += f'''    attr.historizing = true;\n'''
         code += f'''    UA_DataSource {self['function']}_DataSource = (UA_DataSource)\n'''
         code += '''        {\n'''
         code += f'''            .read = get_{self['function']},\n'''
@@ -141,6 +153,7 @@ class Node(dict):
         code += f'''            {self['function']}_DataSource,\n'''
         code += f'''            NULL,\n'''
         code += f'''            NULL);\n'''
+        code += f'''    archive_register_device("{self['name']}", get_{self['function']}, &UA_TYPES[{self['ua_type_desc']}]);\n'''
         return code
 
 class Internal(dict):
@@ -152,10 +165,75 @@ class Internal(dict):
         code += f'''    attr.description = UA_LOCALIZEDTEXT("en_US","{self['description']}");\n'''
         code += f'''    attr.displayName = UA_LOCALIZEDTEXT("en_US","{self['name']}");\n'''
         code += f'''	attr.valueRank = UA_VALUERANK_SCALAR;\n'''
+        if self.get('push') == 'true':
+            # a variable holding the value, updated from the stream snapshot
+            # the values of every pulse are recorded in the history database by the stream reader
+            code += f'''    attr.dataType = UA_TYPES[{self['ua_type_desc']}].typeId;\n'''
+            code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_HISTORYREAD;\n'''
+            code += f'''    attr.historizing = true;\n'''
+            code += f'''    UA_Server_addVariableNode(\n'''
+            code += f'''            server,\n'''
+            code += f'''            UA_NODEID_STRING(1, "{self['name']}"),\n'''
+            code += f'''            {self['parent_node_id']},\n'''
+            code += f'''            UA_NS0ID(ORGANIZES),\n'''
+            code += f'''            UA_QUALIFIEDNAME(1, "{self['name']}"),\n'''
+            code += f'''            UA_NS0ID(BASEDATAVARIABLETYPE),\n'''
+            code += f'''            attr,\n'''
+            code += f'''            NULL,\n'''
+            code += f'''            NULL);\n'''
+            code += f'''    push_register(UA_NODEID_STRING(1, "{self['name']}"), (void *) &({self['var']}), &UA_TYPES[{self['ua_type_desc']}]);\n'''
+            code += f'''    hdb_register(UA_NODEID_STRING(1, "{self['name']}"), (void *) &({self['var']}), &UA_TYPES[{self['ua_type_desc']}]);\n'''
+            code += f'''    archive_register("{self['name']}", (void *) &({self['var']}), &UA_TYPES[{self['ua_type_desc']}]);\n'''
+            return code
+        if self.get('access') == 'rw':
+            code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_WRITE;\n'''
+        elif self.get('history') == 'true':
+            # the values are recorded in the history database by the stream reader
+            code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ | UA_ACCESSLEVELMASK_HISTORYREAD;\n'''
+            code += f'''    attr.historizing = true;\n'''
+        else:
+            code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ;\n'''
+        code += f'''    UA_DataSource {self['name']}_DataSource = (UA_DataSource)\n'''
+        code += '''        {\n'''
+        if 'function' in self.keys():
+            code += f'''            .read = read_{self['function']},\n'''
+        else:
+            code += f'''            .read = read_{self['ua_type']},\n'''
+        if self.get('access') == 'rw':
+            code += f'''            .write = write_{self['ua_type']}\n'''
+        else:
+            code += f'''            .write = NULL\n'''
+        code += '''        };\n'''
+        code += f'''    UA_Server_addDataSourceVariableNode(\n'''
+        code += f'''            server,\n'''
+        code += f'''            UA_NODEID_STRING(1, "{self['name']}"),\n'''
+        code += f'''            {self['parent_node_id']},\n'''
+        code += f'''            UA_NS0ID(ORGANIZES),\n'''
+        code += f'''            UA_QUALIFIEDNAME(1, "{self['name']}"),\n'''
+        code += f'''            UA_NS0ID(BASEDATAVARIABLETYPE),\n'''
+        code += f'''            attr,\n'''
+        code += f'''            {self['name']}_DataSource,\n'''
+        code += f'''            (void *) &({self['var']}),\n'''
+        code += f'''            NULL);\n'''
+        if (self.get('history') == 'true') and (self.get('access') != 'rw'):
+            code += f'''    hdb_register(UA_NODEID_STRING(1, "{self['name']}"), (void *) &({self['var']}), &UA_TYPES[{self['ua_type_desc']}]);\n'''
+        return code
+
+
+
+class Array(dict):
+    def __init__(self, name, parent_node_id):
+        super().__init__(name=name, parent_node_id=parent_node_id)  
+    def generate_main_code(self):
+        code = f'''    attr = UA_VariableAttributes_default;\n'''
+        code += f'''    attr.dataType = UA_TYPES[{self['ua_type_desc']}].typeId;\n'''
+        code += f'''    attr.description = UA_LOCALIZEDTEXT("en_US","{self['description']}");\n'''
+        code += f'''    attr.displayName = UA_LOCALIZEDTEXT("en_US","{self['name']}");\n'''
+        code += f'''	attr.valueRank = UA_VALUERANK_ONE_DIMENSION;\n'''
         code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ;\n'''
         code += f'''    UA_DataSource {self['name']}_DataSource = (UA_DataSource)\n'''
         code += '''        {\n'''
-        code += f'''            .read = read_{self['ua_type']},\n'''
+        code += f'''            .read = read_{self['function']},\n'''
         code += f'''            .write = NULL\n'''
         code += '''        };\n'''
         code += f'''    UA_Server_addDataSourceVariableNode(\n'''
@@ -167,11 +245,42 @@ class Internal(dict):
         code += f'''            UA_NS0ID(BASEDATAVARIABLETYPE),\n'''
         code += f'''            attr,\n'''
         code += f'''            {self['name']}_DataSource,\n'''
-        code += f'''            (void *) &({self['var']}),\n'''
+        if 'context' in self.keys():
+            code += f'''            (void *) &({self['context']}),\n'''
+        else:
+            code += f'''            NULL,\n'''
         code += f'''            NULL);\n'''
         return code
 
 
+class Expression(dict):
+    def __init__(self, name, parent_node_id):
+        super().__init__(name=name, parent_node_id=parent_node_id)  
+    def generate_main_code(self):
+        expr = self['expr'].replace('\\', '\\\\').replace('"', '\\"')
+        code = f'''    attr = UA_VariableAttributes_default;\n'''
+        code += f'''    attr.dataType = UA_TYPES[UA_TYPES_FLOAT].typeId;\n'''
+        code += f'''    attr.description = UA_LOCALIZEDTEXT("en_US","{self['description']}");\n'''
+        code += f'''    attr.displayName = UA_LOCALIZEDTEXT("en_US","{self['name']}");\n'''
+        code += f'''	attr.valueRank = UA_VALUERANK_SCALAR;\n'''
+        code += f'''    attr.accessLevel = UA_ACCESSLEVELMASK_READ;\n'''
+        code += f'''    UA_DataSource {self['name']}_DataSource = (UA_DataSource)\n'''
+        code += '''        {\n'''
+        code += f'''            .read = read_expression,\n'''
+        code += f'''            .write = NULL\n'''
+        code += '''        };\n'''
+        code += f'''    UA_Server_addDataSourceVariableNode(\n'''
+        code += f'''            server,\n'''
+        code += f'''            UA_NODEID_STRING(1, "{self['name']}"),\n'''
+        code += f'''            {self['parent_node_id']},\n'''
+        code += f'''            UA_NS0ID(ORGANIZES),\n'''
+        code += f'''            UA_QUALIFIEDNAME(1, "{self['name']}"),\n'''
+        code += f'''            UA_NS0ID(BASEDATAVARIABLETYPE),\n'''
+        code += f'''            attr,\n'''
+        code += f'''            {self['name']}_DataSource,\n'''
+        code += f'''            expression_compile("{self['name']}", "{expr}"),\n'''
+        code += f'''            NULL);\n'''
+        return code
 
 
 # Load the XML file
@@ -185,6 +294,8 @@ root = tree.getroot()
 List_of_Folders = []
 List_of_Nodes = []
 List_of_Internals = []
+List_of_Arrays = []
+List_of_Expressions = []
 
 def traverse_tree(xml_node, parent_folder):
     # handle all <folder> children
@@ -209,6 +320,20 @@ def traverse_tree(xml_node, parent_folder):
         new_i.update(dict(f.attrib))
         List_of_Internals.append(deepcopy(new_i))
         print('new internal:', new_i)
+    # handle all <array> children
+    for f in xml_node.findall("array"):
+        new_a = Array(name=f.get("name"), parent_node_id=parent_folder['node_id'])
+        # copy all attributes from the XML node into the Node dict
+        new_a.update(dict(f.attrib))
+        List_of_Arrays.append(deepcopy(new_a))
+        print('new array:', new_a)
+    # handle all <expression> children
+    for f in xml_node.findall("expression"):
+        new_e = Expression(name=f.get("name"), parent_node_id=parent_folder['node_id'])
+        # copy all attributes from the XML node into the Node dict
+        new_e.update(dict(f.attrib))
+        List_of_Expressions.append(deepcopy(new_e))
+        print('new expression:', new_e)
 
 root_folder=Folder(name="OBJECTSFOLDER", parent_node_id="None")
 root_folder.update({'node_id':"UA_NS0ID(OBJECTSFOLDER)"})
@@ -227,6 +352,14 @@ for i in List_of_Internals:
     print('Internal: ', i)
 print()
 
+for a in List_of_Arrays:
+    print('Array: ', a)
+print()
+
+for e in List_of_Expressions:
+    print('Expression: ', e)
+print()
+
 # -------------
 # generate code
 # -------------
@@ -238,6 +371,10 @@ for n in List_of_Nodes:
     fd.write(n.generate_main_code())
 for i in List_of_Internals:
     fd.write(i.generate_main_code())
+for a in List_of_Arrays:
+    fd.write(a.generate_main_code())
+for e in List_of_Expressions:
+    fd.write(e.generate_main_code())
 fd.close()
 
 fd = open('libera_mci.h.inc', 'w')
@@ -0,0 +1,340 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file device_clock.c
+  OpcUaServer : model of the instrument clock
+  Version 0.2 2026/10/19
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libera_mci.h"      // the MCI access layer
+#include "device_clock.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t clock_interval = 10;
+double clock_nominal = 0.0;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+int32_t clock_locked = 0;
+int32_t clock_samples = 0;
+double clock_frequency = 0.0;
+float clock_drift = 0.0f;
+float clock_error = 0.0f;
+float clock_rtt = 0.0f;
+uint64_t clock_now_device = 0;
+uint64_t clock_t2_device = 0;
+
+/***********************************/
+/* samples                         */
+/***********************************/
+
+typedef struct {
+    int64_t mono;               // CLOCK_MONOTONIC in the middle of the round trip [ns]
+    int64_t real;               // CLOCK_REALTIME at the same time [ns]
+    uint64_t device;            // device ticks
+    int64_t rtt;                // MCI round trip time [ns]
+} clock_sample;
+
+// the samples are only used by the timer thread
+static clock_sample samples[CLOCK_SAMPLES];
+static int sample_next = 0;
+static int sample_fill = 0;
+static int seconds_since_sample = 0;
+
+static int64_t clock_ns(clockid_t id)
+{
+    struct timespec ts;
+    clock_gettime(id, &ts);
+    return (int64_t)ts.tv_sec * 1000000000 + ts.tv_nsec;
+}
+
+static bool take_sample()
+{
+    clock_sample s;
+    int64_t before = clock_ns(CLOCK_MONOTONIC);
+    int64_t real = clock_ns(CLOCK_REALTIME);
+    if (!mci_get_event_now(&s.device))
+    {
+        printf("MCI value error : device clock sample\n");
+        return false;
+    }
+    int64_t after = clock_ns(CLOCK_MONOTONIC);
+    s.rtt = after - before;
+    s.mono = before + s.rtt / 2;
+    s.real = real + s.rtt / 2;
+    samples[sample_next] = s;
+    sample_next = (sample_next + 1) % CLOCK_SAMPLES;
+    if (sample_fill < CLOCK_SAMPLES) sample_fill++;
+    return true;
+}
+
+/***********************************/
+/* clock model                     */
+/***********************************/
+
+// The model relates the device ticks to CLOCK_MONOTONIC around a reference point
+//   device = ref_device + intercept + slope * (mono - ref_mono)
+// UTC is obtained from CLOCK_MONOTONIC with the offset of the newest sample.
+typedef struct {
+    bool valid;
+    int64_t ref_mono;
+    uint64_t ref_device;
+    double intercept;           // [ticks]
+    double slope;               // [ticks/ns]
+    int64_t real_offset;        // CLOCK_REALTIME - CLOCK_MONOTONIC [ns]
+    float error;                // [ns]
+} clock_model;
+
+// the model is written by the timer thread and read by all other threads
+static clock_model model = { .valid = false };
+static pthread_mutex_t clock_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static int compare_double(const void *a, const void *b)
+{
+    double x = *(const double *)a;
+    double y = *(const double *)b;
+    return (x > y) - (x < y);
+}
+
+static double median(double *v, int n)
+{
+    qsort(v, n, sizeof(double), compare_double);
+    return (n % 2) ? v[n/2] : 0.5 * (v[n/2-1] + v[n/2]);
+}
+
+static void fit_model()
+{
+    static double slopes[CLOCK_SAMPLES * (CLOCK_SAMPLES - 1) / 2];
+    double x[CLOCK_SAMPLES], y[CLOCK_SAMPLES], r[CLOCK_SAMPLES];
+    int n = sample_fill;
+    if (n < CLOCK_MIN_SAMPLES) return;
+
+    // coordinates relative to the newest sample
+    const clock_sample *ref = &samples[(sample_next + CLOCK_SAMPLES - 1) % CLOCK_SAMPLES];
+    for (int i=0; i<n; i++)
+    {
+        x[i] = (double)(samples[i].mono - ref->mono);
+        y[i] = (double)(int64_t)(samples[i].device - ref->device);
+        r[i] = (double)samples[i].rtt;
+    }
+    double rtt = median(r, n);
+
+    // Theil-Sen slope
+    int m = 0;
+    for (int i=0; i<n; i++)
+        for (int j=i+1; j<n; j++)
+            if (x[j] != x[i])
+                slopes[m++] = (y[j] - y[i]) / (x[j] - x[i]);
+    if (m == 0) return;
+    double slope = median(slopes, m);
+    if (slope <= 0.0)
+    {
+        printf("OpcUaServer : device clock not running\n");
+        return;
+    }
+    for (int i=0; i<n; i++)
+        r[i] = y[i] - slope * x[i];
+    double intercept = median(r, n);
+    // robust spread of the residuals, converted to ns
+    for (int i=0; i<n; i++)
+        r[i] = fabs(y[i] - intercept - slope * x[i]);
+    double sigma = 1.4826 * median(r, n) / slope;
+
+    clock_model mo;
+    mo.valid = true;
+    mo.ref_mono = ref->mono;
+    mo.ref_device = ref->device;
+    mo.intercept = intercept;
+    mo.slope = slope;
+    mo.real_offset = ref->real - ref->mono;
+    mo.error = (float)(sigma + 0.5 * rtt);
+    pthread_mutex_lock(&clock_lock);
+    model = mo;
+    clock_frequency = slope * 1e9;
+    pthread_mutex_unlock(&clock_lock);
+
+    clock_locked = 1;
+    clock_samples = n;
+    clock_drift = (clock_nominal > 0.0) ? (float)((clock_frequency - clock_nominal) / clock_nominal * 1e6) : 0.0f;
+    clock_error = mo.error;
+    clock_rtt = (float)(rtt * 1e-3);
+}
+
+void clock_update()
+{
+    seconds_since_sample++;
+    int interval = (clock_interval > 0) ? clock_interval : 1;
+    if ((sample_fill < CLOCK_MIN_SAMPLES) || (seconds_since_sample >= interval))
+    {
+        if (take_sample())
+            fit_model();
+        seconds_since_sample = 0;
+    }
+    uint64_t t2;
+    if (mci_get_t2_time(&t2))
+    {
+        pthread_mutex_lock(&clock_lock);
+        clock_t2_device = t2;
+        pthread_mutex_unlock(&clock_lock);
+    }
+}
+
+/***********************************/
+/* conversions                     */
+/***********************************/
+
+// the conversions work on a copy of the model taken under the lock
+static int64_t device_to_utc(const clock_model *mo, uint64_t ticks)
+{
+    double dy = (double)(int64_t)(ticks - mo->ref_device) - mo->intercept;
+    int64_t mono = mo->ref_mono + (int64_t)llround(dy / mo->slope);
+    return mono + mo->real_offset;
+}
+
+bool clock_device_to_utc(uint64_t ticks, int64_t *utc, float *error)
+{
+    pthread_mutex_lock(&clock_lock);
+    clock_model mo = model;
+    pthread_mutex_unlock(&clock_lock);
+    if (!mo.valid) return false;
+    *utc = device_to_utc(&mo, ticks);
+    if (error != NULL) *error = mo.error;
+    return true;
+}
+
+bool clock_utc_to_device(int64_t utc, uint64_t *ticks, double *frequency)
+{
+    pthread_mutex_lock(&clock_lock);
+    clock_model mo = model;
+    pthread_mutex_unlock(&clock_lock);
+    if (!mo.valid) return false;
+    double dx = (double)(utc - mo.real_offset - mo.ref_mono);
+    *ticks = mo.ref_device + (uint64_t)llround(mo.intercept + mo.slope * dx);
+    if (frequency != NULL) *frequency = mo.slope * 1e9;
+    return true;
+}
+
+// Convert the device time held in *var, which is written under the lock
+// by the timer thread, the time and the error come from the same model.
+static bool clock_read_utc(const void *var, int64_t *utc, float *error)
+{
+    pthread_mutex_lock(&clock_lock);
+    clock_model mo = model;
+    uint64_t ticks = *(const uint64_t *)var;
+    pthread_mutex_unlock(&clock_lock);
+    if (!mo.valid) return false;
+    *utc = device_to_utc(&mo, ticks);
+    *error = mo.error;
+    return true;
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_clock_now_device(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    uint64_t ticks;
+    if (!clock_utc_to_device(clock_ns(CLOCK_REALTIME), &ticks, NULL))
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    clock_now_device = ticks;
+    UA_UInt64 value = ticks;
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_UINT64]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode read_clock_utc(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    int64_t utc;
+    float error;
+    if (nodeContext == NULL)
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    if (!clock_read_utc(nodeContext, &utc, &error))
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    UA_DateTime value = utc / 100 + UA_DATETIME_UNIX_EPOCH;
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_DATETIME]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode read_clock_utc_error(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    int64_t utc;
+    UA_Float error;
+    if (nodeContext == NULL)
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    if (!clock_read_utc(nodeContext, &utc, &error))
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    UA_Variant_setScalarCopy(&dataValue->value, &error, &UA_TYPES[UA_TYPES_FLOAT]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode read_clock_frequency(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    pthread_mutex_lock(&clock_lock);
+    UA_Double value = clock_frequency;
+    pthread_mutex_unlock(&clock_lock);
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
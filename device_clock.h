@@ -0,0 +1,143 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file device_clock.h
+  OpcUaServer : model of the instrument clock
+  Version 0.2 2026/10/19
+
+  The instrument time (application.events.current_time) counts device ticks.
+  Reading it takes a full MCI round trip. Instead of reading it for every
+  request, the device time is sampled periodically together with
+  CLOCK_MONOTONIC and CLOCK_REALTIME. The device tick is assumed
+  to be taken in the middle of the MCI round trip.
+
+  Offset and rate of the device clock against CLOCK_MONOTONIC are fitted
+  with the Theil-Sen estimator (median of the pairwise slopes) over the
+  last CLOCK_SAMPLES samples, which is insensitive to single samples
+  delayed by the MCI latency. The device time is then extrapolated locally
+  and converted to UTC with the current offset of CLOCK_REALTIME.
+
+  The error estimate is the robust spread of the fit residuals
+  plus half the median MCI round trip time.
+
+  The model is published by the timer thread as one record under a lock,
+  every conversion uses a consistent copy of offset, slope and error.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef DEVICECLOCK_H
+#define DEVICECLOCK_H
+
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of samples kept for the fit
+#define CLOCK_SAMPLES 64
+// number of samples required for a valid model
+// until then a sample is taken every second
+#define CLOCK_MIN_SAMPLES 8
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t clock_interval;          // time between samples [s]
+extern double clock_nominal;            // nominal device clock frequency [Hz], 0=unknown
+
+//*************************************
+// results
+//*************************************
+
+extern int32_t clock_locked;            // 1 if the model is valid
+extern int32_t clock_samples;           // number of samples used for the fit
+extern double clock_frequency;          // fitted device clock frequency [Hz], written under the lock
+extern float clock_drift;               // deviation from the nominal frequency [ppm]
+extern float clock_error;               // error of the converted times [ns]
+extern float clock_rtt;                 // median MCI round trip time [us]
+extern uint64_t clock_now_device;       // device time at the last read
+extern uint64_t clock_t2_device;        // device time of the last t2 trigger (read every second, under the lock)
+
+// to be called once every second from the timer thread
+void clock_update();
+
+// convert a device time into UTC [ns since 1970]
+// returns false if there is no valid model yet
+bool clock_device_to_utc(uint64_t ticks, int64_t *utc, float *error);
+
+// convert UTC [ns since 1970] into device time
+// frequency (NULL ok) receives the clock frequency of the model used [Hz]
+// returns false if there is no valid model yet
+bool clock_utc_to_device(int64_t utc, uint64_t *ticks, double *frequency);
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// the extrapolated device time
+UA_StatusCode read_clock_now_device(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+// the UTC time of the device time pointed to by nodeContext
+UA_StatusCode read_clock_utc(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+// the error estimate [ns] of the UTC time of the device time pointed to by nodeContext
+UA_StatusCode read_clock_utc_error(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+// the fitted clock frequency, read under the lock
+UA_StatusCode read_clock_frequency(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
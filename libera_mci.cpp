@@ -30,6 +30,7 @@ SOFTWARE.
 
 #include <stdio.h>
 #include <stdlib.h>
+#include <pthread.h>
 
 #include "mci/mci.h"
 
@@ -40,6 +41,10 @@ mci::Node node_root;
 mci::Node node_pulse_processing_enable;
 mci::Node node_pulse_processing_threshold;
 
+// MCI is accessed from the timer, autorange, trigger and server threads,
+// all accesses to the nodes are serialized
+static pthread_mutex_t mci_lock = PTHREAD_MUTEX_INITIALIZER;
+
 //*************************************
 // persistent variables for MCI nodes
 // code by code_generator.py
@@ -94,17 +99,21 @@ bool mci_get_pulse_enable(bool *val)
 {
     // false=0 true=1
     int mci_enum;
+    pthread_mutex_lock(&mci_lock);
     bool success = node_pulse_enable.GetValue(mci_enum);
+    pthread_mutex_unlock(&mci_lock);
     *val = (mci_enum==1);
     return success;
 }
 bool mci_set_pulse_enable(bool val)
 {
     bool success;
+    pthread_mutex_lock(&mci_lock);
     if (val)
         success = node_pulse_enable.SetValue("true");
     else
         success = node_pulse_enable.SetValue("false");
+    pthread_mutex_unlock(&mci_lock);
     return success;
 }
 
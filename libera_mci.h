@@ -31,6 +31,9 @@ SOFTWARE.
   compiler parameters. Therefore, the instrument access is divided
   into 2 layers, one providing the MCI access and one
   handling the OPC-UA variables on top of it.
+
+  The read/write methods may be called from any thread,
+  the accesses are serialized by a mutex.
  */
 
 #include <stdio.h>
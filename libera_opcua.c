@@ -34,6 +34,8 @@ SOFTWARE.
 
 #include "libera_mci.h"      // the MCI access layer
 #include "libera_opcua.h"
+#include "pulse_calibration.h"
+#include "pulse_rate.h"
 
 //*************************************
 // read/write methods for MCI variables
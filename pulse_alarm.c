@@ -0,0 +1,298 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_alarm.c
+  OpcUaServer : limit check of the pulse data
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <pthread.h>
+
+#include "pulse_alarm.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t alarm_field = FIELD_PEAK;
+int32_t alarm_enable[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t alarm_high[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t alarm_low[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t alarm_hysteresis[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t alarm_deadtime = 100;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+int32_t alarm_state[PULSE_CHANNELS] = { ALARM_NORMAL, ALARM_NORMAL, ALARM_NORMAL, ALARM_NORMAL };
+int32_t alarm_count = 0;
+int32_t alarm_suppressed = 0;
+int32_t alarm_dropped = 0;
+
+// ingest time of the last event per channel [ns], 0 before the first event
+static int64_t last_event[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+// the state held back by the dead time per channel, ALARM_NORMAL if none
+static int pending[PULSE_CHANNELS] = { ALARM_NORMAL, ALARM_NORMAL, ALARM_NORMAL, ALARM_NORMAL };
+
+/***********************************/
+/* event queue                     */
+/***********************************/
+
+typedef struct {
+    uint64_t sequence;
+    int64_t timestamp;
+    uint64_t trigger;           // associated t2 trigger, 0=none
+    int32_t channel;            // 0..3
+    int32_t field;
+    int32_t state;              // ALARM_HIGH or ALARM_LOW
+    int32_t value;
+    int32_t limit;
+} alarm_event;
+
+// written by the stream reader thread, read by the server thread
+static alarm_event queue[ALARM_QUEUE];
+static int queue_head = 0;      // next entry to be written
+static int queue_fill = 0;
+static pthread_mutex_t alarm_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void queue_event(const alarm_event *ev)
+{
+    pthread_mutex_lock(&alarm_lock);
+    if (queue_fill == ALARM_QUEUE)
+        alarm_dropped++;
+    else
+    {
+        queue[queue_head] = *ev;
+        queue_head = (queue_head + 1) % ALARM_QUEUE;
+        queue_fill++;
+    }
+    pthread_mutex_unlock(&alarm_lock);
+}
+
+/***********************************/
+/* limit check                     */
+/***********************************/
+
+// returns false if the event is held back by the dead time
+static bool raise_alarm(int ch, int field, int state, int32_t value, int32_t limit, const pulse_info *info, int64_t deadtime)
+{
+    if ((last_event[ch] != 0) && (info->timestamp - last_event[ch] < deadtime))
+        return false;
+    last_event[ch] = info->timestamp;
+    alarm_event ev = {
+        .sequence = info->sequence,
+        .timestamp = info->timestamp,
+        .trigger = info->trigger,
+        .channel = ch,
+        .field = field,
+        .state = state,
+        .value = value,
+        .limit = limit };
+    queue_event(&ev);
+    alarm_count++;
+    return true;
+}
+
+void alarm_process(const pulse_data *blocks, const pulse_info *info, int count)
+{
+    // take a copy of the configuration, it may be modified by the server at any time
+    int field = alarm_field;
+    if ((field < 0) || (field >= PULSE_FIELDS)) field = FIELD_PEAK;
+    int64_t deadtime = (int64_t)alarm_deadtime * 1000000;
+
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        if (!alarm_enable[ch])
+        {
+            alarm_state[ch] = ALARM_NORMAL;
+            pending[ch] = ALARM_NORMAL;
+            continue;
+        }
+        int32_t high = alarm_high[ch];
+        int32_t low = alarm_low[ch];
+        int32_t hyst = alarm_hysteresis[ch];
+        int state = alarm_state[ch];
+        for (int k=0; k<count; k++)
+        {
+            // the values are not reliable while the attenuation is changed
+            if (info[k].flags & PULSE_FLAG_RANGING) continue;
+            int32_t v = PULSE_VALUE(&blocks[k], ch, field);
+            // return to normal only with the hysteresis
+            if ((state == ALARM_HIGH) && ((int64_t)v < (int64_t)high - hyst))
+                state = ALARM_NORMAL;
+            if ((state == ALARM_LOW) && ((int64_t)v > (int64_t)low + hyst))
+                state = ALARM_NORMAL;
+            if (state != ALARM_NORMAL) continue;
+            int target = (v > high) ? ALARM_HIGH : (v < low) ? ALARM_LOW : ALARM_NORMAL;
+            if (target == ALARM_NORMAL)
+            {
+                pending[ch] = ALARM_NORMAL;
+                continue;
+            }
+            // Within the dead time the state is left unchanged, a persisting
+            // violation raises its event with the first block after the dead time.
+            if (raise_alarm(ch, field, target, v, (target == ALARM_HIGH) ? high : low, &info[k], deadtime))
+            {
+                state = target;
+                pending[ch] = ALARM_NORMAL;
+            }
+            else if (pending[ch] != target)
+            {
+                alarm_suppressed++;
+                pending[ch] = target;
+            }
+        }
+        alarm_state[ch] = state;
+    }
+}
+
+/***********************************/
+/* OPC-UA events                   */
+/***********************************/
+
+#define ALARM_EVENT_TYPE UA_NODEID_STRING(1, "PulseLimitEventType")
+
+static const char *field_names[PULSE_FIELDS] = { "rss", "peak", "avg", "sum" };
+
+static UA_StatusCode add_event_property(UA_Server *server, char *name, char *description, const UA_DataType *type)
+{
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", name);
+    attr.description = UA_LOCALIZEDTEXT("en_US", description);
+    attr.dataType = type->typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    UA_NodeId propertyId;
+    UA_StatusCode retval = UA_Server_addVariableNode(
+            server,
+            UA_NODEID_NULL,
+            ALARM_EVENT_TYPE,
+            UA_NS0ID(HASPROPERTY),
+            UA_QUALIFIEDNAME(1, name),
+            UA_NS0ID(PROPERTYTYPE),
+            attr,
+            NULL,
+            &propertyId);
+    if (retval != UA_STATUSCODE_GOOD) return retval;
+    // the property has to be instantiated with every event
+    retval = UA_Server_addReference(
+            server,
+            propertyId,
+            UA_NS0ID(HASMODELLINGRULE),
+            UA_NS0EXID(MODELLINGRULE_MANDATORY),
+            true);
+    UA_NodeId_clear(&propertyId);
+    return retval;
+}
+
+static void trigger_event(UA_Server *server, const alarm_event *ev)
+{
+    UA_NodeId eventId;
+    if (UA_Server_createEvent(server, ALARM_EVENT_TYPE, &eventId) != UA_STATUSCODE_GOOD)
+    {
+        printf("OpcUaServer : failed to create limit event\n");
+        return;
+    }
+    UA_DateTime time = ev->timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Time"),
+                                         &time, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_UInt16 severity = 500;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Severity"),
+                                         &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    char text[128];
+    snprintf(text, sizeof(text), "Ch%d %s %d %s limit %d",
+             ev->channel + 1, field_names[ev->field], ev->value,
+             (ev->state == ALARM_HIGH) ? "above high" : "below low", ev->limit);
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en_US", text);
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Message"),
+                                         &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_String source = UA_STRING("Pulse_acquisition");
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "SourceName"),
+                                         &source, &UA_TYPES[UA_TYPES_STRING]);
+    UA_UInt32 channel = ev->channel + 1;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Channel"),
+                                         &channel, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Int32 value = ev->value;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Value"),
+                                         &value, &UA_TYPES[UA_TYPES_INT32]);
+    UA_Int32 limit = ev->limit;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Limit"),
+                                         &limit, &UA_TYPES[UA_TYPES_INT32]);
+    UA_UInt64 sequence = ev->sequence;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Sequence"),
+                                         &sequence, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_UInt64 trigger = ev->trigger;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Trigger"),
+                                         &trigger, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Server_triggerEvent(server, eventId, UA_NS0ID(SERVER), NULL, true);
+}
+
+// called by the server thread every ALARM_INTERVAL ms
+static void alarm_callback(UA_Server *server, void *data)
+{
+    alarm_event pending[ALARM_QUEUE];
+    pthread_mutex_lock(&alarm_lock);
+    int n = queue_fill;
+    int start = (queue_head - queue_fill + ALARM_QUEUE) % ALARM_QUEUE;
+    for (int i=0; i<n; i++)
+        pending[i] = queue[(start + i) % ALARM_QUEUE];
+    queue_fill = 0;
+    pthread_mutex_unlock(&alarm_lock);
+    for (int i=0; i<n; i++)
+        trigger_event(server, &pending[i]);
+}
+
+UA_StatusCode alarm_add_events(UA_Server *server)
+{
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", "PulseLimitEventType");
+    attr.description = UA_LOCALIZEDTEXT("en_US", "a pulse value has crossed a limit");
+    UA_StatusCode retval = UA_Server_addObjectTypeNode(
+            server,
+            ALARM_EVENT_TYPE,
+            UA_NS0ID(BASEEVENTTYPE),
+            UA_NS0ID(HASSUBTYPE),
+            UA_QUALIFIEDNAME(1, "PulseLimitEventType"),
+            attr,
+            NULL,
+            NULL);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Channel", "channel 1..4", &UA_TYPES[UA_TYPES_UINT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Value", "offending value", &UA_TYPES[UA_TYPES_INT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Limit", "crossed limit", &UA_TYPES[UA_TYPES_INT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Sequence", "sequence number of the block", &UA_TYPES[UA_TYPES_UINT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Trigger", "index of the associated t2 trigger, 0=none", &UA_TYPES[UA_TYPES_UINT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = UA_Server_addRepeatedCallback(server, alarm_callback, NULL, ALARM_INTERVAL, NULL);
+    if (retval != UA_STATUSCODE_GOOD)
+        printf("OpcUaServer : failed to add the limit events %8x\n", retval);
+    return retval;
+}
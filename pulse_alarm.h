@@ -0,0 +1,98 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_alarm.h
+  OpcUaServer : limit check of the pulse data
+  Version 0.2 2026/10/19
+
+  Every ingested block is checked against a high and a low limit per channel,
+  before the outlier rejection and the coincidence filter.
+  A channel enters the high (low) state when the value exceeds (falls below)
+  the limit and returns to normal only when the value is back inside
+  the limit by more than the hysteresis.
+  Entering the high or low state raises an event of type PulseLimitEventType
+  carrying the channel, the value, the limit, the sequence number
+  and the associated t2 trigger.
+  The event time is the ingest time of the offending block.
+  After an event the channel is silent for the dead time. A violation
+  within that time is counted and leaves the state unchanged, if it
+  persists its event is raised with the first block after the dead time.
+
+  The limit check runs in the stream reader thread, it only queues the events.
+  The events are triggered by a callback of the server thread.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEALARM_H
+#define PULSEALARM_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ALARM_NORMAL 0
+#define ALARM_HIGH 1
+#define ALARM_LOW -1
+
+// number of events that can wait for the server thread
+#define ALARM_QUEUE 256
+// interval of the server callback triggering the events [ms]
+#define ALARM_INTERVAL 50
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t alarm_field;                         // checked field FIELD_*
+extern int32_t alarm_enable[PULSE_CHANNELS];        // 0=off 1=on
+extern int32_t alarm_high[PULSE_CHANNELS];          // high limit
+extern int32_t alarm_low[PULSE_CHANNELS];           // low limit
+extern int32_t alarm_hysteresis[PULSE_CHANNELS];    // hysteresis of both limits
+extern int32_t alarm_deadtime;                      // silence after an event [ms]
+
+//*************************************
+// results
+//*************************************
+
+extern int32_t alarm_state[PULSE_CHANNELS];         // ALARM_*
+extern int32_t alarm_count;                         // number of events raised
+extern int32_t alarm_suppressed;                    // violations held back by the dead time
+extern int32_t alarm_dropped;                       // events lost by a full queue
+
+// check a batch of data blocks against the limits
+void alarm_process(const pulse_data *blocks, const pulse_info *info, int count);
+
+// add the event type and start triggering the queued events
+UA_StatusCode alarm_add_events(UA_Server *server);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
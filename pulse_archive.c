@@ -0,0 +1,1309 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_archive.c
+  OpcUaServer : on-disk archive of the historized stream variables
+  Version 0.2 2026/10/19
+ */
+
+#define _DEFAULT_SOURCE             // for pread(), fsync() and dirent with -std=c99
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <errno.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <dirent.h>
+#include <sys/stat.h>
+#include <pthread.h>
+
+#include "pulse_archive.h"
+
+int32_t archive_enable = 0;
+int32_t archive_segment_rows = 65536;
+int32_t archive_retention_mb = 256;
+int32_t archive_retention_days = 30;
+
+int32_t archive_segments = 0;
+float archive_size_mb = 0.0f;
+uint32_t archive_dropped = 0;
+uint32_t archive_errors = 0;
+
+/***********************************/
+/* summaries                       */
+/***********************************/
+
+void archive_summary_init(archive_summary *s)
+{
+    s->count = 0;
+    s->mean = 0.0;
+    s->m2 = 0.0;
+    s->min = 0.0;
+    s->max = 0.0;
+}
+
+void archive_summary_add(archive_summary *s, double x)
+{
+    if (s->count == 0)
+    {
+        s->min = x;
+        s->max = x;
+    }
+    else
+    {
+        if (x < s->min) s->min = x;
+        if (x > s->max) s->max = x;
+    }
+    s->count++;
+    double delta = x - s->mean;
+    s->mean += delta / s->count;
+    s->m2 += delta * (x - s->mean);
+}
+
+void archive_summary_merge(archive_summary *s, const archive_summary *t)
+{
+    if (t->count == 0) return;
+    if (s->count == 0)
+    {
+        *s = *t;
+        return;
+    }
+    double n = (double)s->count + (double)t->count;
+    double delta = t->mean - s->mean;
+    s->m2 += t->m2 + delta * delta * (double)s->count * (double)t->count / n;
+    s->mean += delta * (double)t->count / n;
+    s->count += t->count;
+    if (t->min < s->min) s->min = t->min;
+    if (t->max > s->max) s->max = t->max;
+}
+
+double archive_value(const void *value, uint32_t type)
+{
+    switch (type)
+    {
+        case UA_NS0ID_BOOLEAN: return *(const UA_Boolean *)value ? 1.0 : 0.0;
+        case UA_NS0ID_SBYTE: return *(const UA_SByte *)value;
+        case UA_NS0ID_BYTE: return *(const UA_Byte *)value;
+        case UA_NS0ID_INT16: return *(const UA_Int16 *)value;
+        case UA_NS0ID_UINT16: return *(const UA_UInt16 *)value;
+        case UA_NS0ID_INT32: return *(const UA_Int32 *)value;
+        case UA_NS0ID_UINT32: return *(const UA_UInt32 *)value;
+        case UA_NS0ID_INT64: return (double)*(const UA_Int64 *)value;
+        case UA_NS0ID_UINT64: return (double)*(const UA_UInt64 *)value;
+        case UA_NS0ID_FLOAT: return *(const UA_Float *)value;
+        case UA_NS0ID_DOUBLE: return *(const UA_Double *)value;
+        default: return 0.0;
+    }
+}
+
+/***********************************/
+/* file layout                     */
+/***********************************/
+
+#define ARCHIVE_MAGIC 0x56435241    // "ARCV"
+#define ARCHIVE_VERSION 2
+#define ARCHIVE_NAME 32
+// the directory name and the complete path of a file, including the terminating 0
+#define ARCHIVE_DIR_LENGTH 256
+#define ARCHIVE_PATH (ARCHIVE_DIR_LENGTH + 256)
+
+// A segment file consists of
+//   archive_header
+//   archive_column[columns]
+//   int64_t index[(rows+stride-1)/stride]    time of every stride-th row
+//   int64_t time[rows]                       UA_DateTime of every row
+//   the value columns, rows*size bytes each
+//   archive_summary[(rows+stride-1)/stride] for every column,
+//   the partial aggregates of the blocks of stride rows
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t columns;
+    uint32_t rows;
+    uint32_t stride;
+    uint32_t series;                // SERIES_PULSE or SERIES_DEVICE
+    int64_t first_time;
+    int64_t last_time;
+    uint64_t index_offset;
+    uint64_t time_offset;
+    uint64_t size;                  // of the whole file
+} archive_header;
+
+typedef struct {
+    char name[ARCHIVE_NAME];        // string node id of the variable
+    uint32_t size;                  // bytes per value
+    uint32_t type;                  // numeric node id of the data type
+    uint64_t offset;                // file offset of the column
+    uint64_t summary;               // file offset of the block summaries
+    archive_summary total;          // aggregate of the whole column
+} archive_column;
+
+/***********************************/
+/* archived variables              */
+/***********************************/
+
+// The rows of a series hold the values of its variables at one time.
+// The values of a row are read from a buffer at the offsets of the variables,
+// the stream snapshot for SERIES_PULSE and device_values for SERIES_DEVICE.
+typedef struct {
+    char name[ARCHIVE_NAME];
+    size_t offset;                  // of the value within the row buffer
+    archive_read_function read;     // SERIES_DEVICE
+    const UA_DataType *type;
+} archive_variable;
+
+/***********************************/
+/* segments                        */
+/***********************************/
+
+#define SEGMENT_CURRENT 0           // being filled
+#define SEGMENT_PENDING 1           // full, waiting to be written
+#define SEGMENT_FILE 2              // written to disk
+
+typedef struct {
+    int state;
+    uint32_t series;
+    UA_DateTime first_time;
+    UA_DateTime last_time;
+    uint32_t rows;
+    uint32_t columns;
+    archive_column column[ARCHIVE_COLUMNS];
+    // SEGMENT_FILE
+    char path[ARCHIVE_PATH];
+    uint64_t file_size;
+    uint64_t time_offset;
+    uint32_t stride;
+    int64_t *index;
+    // SEGMENT_CURRENT and SEGMENT_PENDING
+    uint32_t capacity;
+    int64_t *time;
+    char *data[ARCHIVE_COLUMNS];
+} archive_segment;
+
+// Every series has its own list of segments ordered by time, the files first,
+// followed by the pending segments and the current one. The lists are
+// modified by the stream reader thread (appending pulses), the timer thread
+// (appending device values, writing, deleting) and read by the server thread.
+typedef struct {
+    archive_variable variables[ARCHIVE_COLUMNS];
+    int variable_count;
+    archive_segment **segments;
+    int segment_count;
+    int segment_alloc;
+    UA_DateTime last_time;          // of the last row appended
+} archive_series;
+
+static archive_series series[ARCHIVE_SERIES];
+static pthread_mutex_t archive_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static char archive_dir[ARCHIVE_DIR_LENGTH];
+static bool archive_opened = false;
+
+// the last values read from the device, one row of SERIES_DEVICE
+static char device_values[ARCHIVE_COLUMNS][sizeof(UA_Double)];
+static bool device_valid = false;
+
+static bool add_variable(archive_series *ser, const char *name, size_t offset,
+                         archive_read_function read, const UA_DataType *type)
+{
+    if ((ser->variable_count == ARCHIVE_COLUMNS) || (strlen(name) >= ARCHIVE_NAME))
+    {
+        printf("OpcUaServer : variable %s can not be archived\n", name);
+        return false;
+    }
+    archive_variable *var = &ser->variables[ser->variable_count];
+    strcpy(var->name, name);
+    var->offset = offset;
+    var->read = read;
+    var->type = type;
+    ser->variable_count++;
+    return true;
+}
+
+void archive_register(const char *name, const void *var, const UA_DataType *type)
+{
+    const char *base = (const char *)&stream_snapshot;
+    if (((const char *)var < base) || ((const char *)var + type->memSize > base + sizeof(pulse_snapshot)))
+    {
+        printf("OpcUaServer : archived variable %s not within the stream snapshot\n", name);
+        return;
+    }
+    add_variable(&series[SERIES_PULSE], name, (const char *)var - base, NULL, type);
+}
+
+void archive_register_device(const char *name, archive_read_function read, const UA_DataType *type)
+{
+    if (type->memSize > sizeof(UA_Double))
+    {
+        printf("OpcUaServer : variable %s can not be archived\n", name);
+        return;
+    }
+    archive_series *ser = &series[SERIES_DEVICE];
+    add_variable(ser, name, ser->variable_count * sizeof(UA_Double), read, type);
+}
+
+static void segment_free(archive_segment *seg)
+{
+    free(seg->index);
+    free(seg->time);
+    for (uint32_t c=0; c<seg->columns; c++)
+        free(seg->data[c]);
+    free(seg);
+}
+
+static bool list_append(archive_series *ser, archive_segment *seg)
+{
+    if (ser->segment_count == ser->segment_alloc)
+    {
+        int n = (ser->segment_alloc == 0) ? 64 : 2 * ser->segment_alloc;
+        archive_segment **p = (archive_segment **) realloc(ser->segments, n * sizeof(archive_segment *));
+        if (p == NULL) return false;
+        ser->segments = p;
+        ser->segment_alloc = n;
+    }
+    ser->segments[ser->segment_count++] = seg;
+    return true;
+}
+
+static void list_remove(archive_series *ser, int i)
+{
+    segment_free(ser->segments[i]);
+    memmove(&ser->segments[i], &ser->segments[i+1], (ser->segment_count - i - 1) * sizeof(archive_segment *));
+    ser->segment_count--;
+}
+
+static archive_segment *new_segment(const archive_series *ser)
+{
+    uint32_t capacity = archive_segment_rows;
+    if (capacity < ARCHIVE_STRIDE) capacity = ARCHIVE_STRIDE;
+    if (capacity > 0x400000) capacity = 0x400000;
+    archive_segment *seg = (archive_segment *) calloc(1, sizeof(archive_segment));
+    if (seg == NULL) return NULL;
+    seg->state = SEGMENT_CURRENT;
+    seg->series = ser - series;
+    seg->capacity = capacity;
+    seg->columns = ser->variable_count;
+    seg->time = (int64_t *) malloc(capacity * sizeof(int64_t));
+    bool ok = (seg->time != NULL);
+    for (int c=0; c<ser->variable_count; c++)
+    {
+        strcpy(seg->column[c].name, ser->variables[c].name);
+        seg->column[c].size = ser->variables[c].type->memSize;
+        seg->column[c].type = ser->variables[c].type->typeId.identifier.numeric;
+        seg->data[c] = (char *) malloc((size_t)capacity * seg->column[c].size);
+        if (seg->data[c] == NULL) ok = false;
+    }
+    if (!ok)
+    {
+        segment_free(seg);
+        return NULL;
+    }
+    return seg;
+}
+
+// append one row read from the buffer, archive_lock must be held
+static void append_row(archive_series *ser, UA_DateTime time, const char *values)
+{
+    archive_segment *cur = NULL;
+    if ((ser->segment_count > 0) && (ser->segments[ser->segment_count-1]->state == SEGMENT_CURRENT))
+        cur = ser->segments[ser->segment_count-1];
+    if ((cur != NULL) && (cur->rows == cur->capacity))
+    {
+        int pending = 0;
+        for (int s=0; s<ARCHIVE_SERIES; s++)
+            for (int i=0; i<series[s].segment_count; i++)
+                if (series[s].segments[i]->state == SEGMENT_PENDING) pending++;
+        if (pending >= ARCHIVE_PENDING)
+        {
+            archive_dropped++;
+            return;
+        }
+        cur->state = SEGMENT_PENDING;
+        cur = NULL;
+    }
+    if (cur == NULL)
+    {
+        cur = new_segment(ser);
+        if ((cur == NULL) || !list_append(ser, cur))
+        {
+            if (cur != NULL) segment_free(cur);
+            archive_dropped++;
+            return;
+        }
+    }
+    // keep the archive ordered in time if the clock was set back
+    if (time < ser->last_time) time = ser->last_time;
+    ser->last_time = time;
+    uint32_t r = cur->rows;
+    cur->time[r] = time;
+    for (uint32_t c=0; c<cur->columns; c++)
+        memcpy(cur->data[c] + (size_t)r * cur->column[c].size,
+               values + ser->variables[c].offset, cur->column[c].size);
+    if (r == 0) cur->first_time = time;
+    cur->last_time = time;
+    cur->rows++;
+}
+
+void archive_process(const pulse_snapshot *states, int count)
+{
+    archive_series *ser = &series[SERIES_PULSE];
+    if (!archive_enable || !archive_opened || (ser->variable_count == 0)) return;
+    pthread_mutex_lock(&archive_lock);
+    for (int k=0; k<count; k++)
+        if (states[k].timestamp != 0)
+            append_row(ser, states[k].timestamp / 100 + UA_DATETIME_UNIX_EPOCH, (const char *)&states[k]);
+    pthread_mutex_unlock(&archive_lock);
+}
+
+// Read all device variables, a row is appended when any of them changed.
+// Nothing is recorded while the device can not be read.
+static void sample_device()
+{
+    archive_series *ser = &series[SERIES_DEVICE];
+    if (!archive_enable || (ser->variable_count == 0)) return;
+    char values[ARCHIVE_COLUMNS][sizeof(UA_Double)];
+    memset(values, 0, sizeof(values));
+    for (int c=0; c<ser->variable_count; c++)
+    {
+        const archive_variable *var = &ser->variables[c];
+        UA_DataValue value;
+        UA_DataValue_init(&value);
+        bool ok = (var->read(NULL, NULL, NULL, NULL, NULL, false, NULL, &value) == UA_STATUSCODE_GOOD) &&
+                  value.hasValue && UA_Variant_hasScalarType(&value.value, var->type);
+        if (ok) memcpy(values[c], value.value.data, var->type->memSize);
+        UA_DataValue_clear(&value);
+        if (!ok) return;
+    }
+    if (device_valid && (memcmp(values, device_values, sizeof(values)) == 0)) return;
+    memcpy(device_values, values, sizeof(values));
+    device_valid = true;
+    pthread_mutex_lock(&archive_lock);
+    append_row(ser, UA_DateTime_now(), (const char *)device_values);
+    pthread_mutex_unlock(&archive_lock);
+}
+
+/***********************************/
+/* writing and loading files       */
+/***********************************/
+
+// The segment is written by the timer thread without holding the lock.
+// Pending segments are not modified by any other thread.
+static bool write_segment(archive_segment *seg, char *path, archive_header *hdr, archive_column *column, int64_t **index)
+{
+    if (snprintf(path, ARCHIVE_PATH, "%s/seg_%u_%020lld.dat", archive_dir, seg->series, (long long)seg->first_time) >= ARCHIVE_PATH)
+        return false;
+    archive_header header;
+    memset(&header, 0, sizeof(header));
+    header.magic = ARCHIVE_MAGIC;
+    header.version = ARCHIVE_VERSION;
+    header.columns = seg->columns;
+    header.rows = seg->rows;
+    header.stride = ARCHIVE_STRIDE;
+    header.series = seg->series;
+    header.first_time = seg->first_time;
+    header.last_time = seg->last_time;
+    uint32_t nidx = (seg->rows + ARCHIVE_STRIDE - 1) / ARCHIVE_STRIDE;
+    header.index_offset = sizeof(archive_header) + seg->columns * sizeof(archive_column);
+    header.time_offset = header.index_offset + nidx * sizeof(int64_t);
+    uint64_t offset = header.time_offset + (uint64_t)seg->rows * sizeof(int64_t);
+    for (uint32_t c=0; c<seg->columns; c++)
+    {
+        column[c] = seg->column[c];
+        column[c].offset = offset;
+        offset += (uint64_t)seg->rows * column[c].size;
+    }
+    for (uint32_t c=0; c<seg->columns; c++)
+    {
+        column[c].summary = offset;
+        offset += nidx * sizeof(archive_summary);
+    }
+    header.size = offset;
+    *hdr = header;
+    *index = (int64_t *) malloc(nidx * sizeof(int64_t));
+    archive_summary *summary = (archive_summary *) malloc(nidx * sizeof(archive_summary));
+    if ((*index == NULL) || (summary == NULL))
+    {
+        free(summary);
+        return false;
+    }
+    for (uint32_t k=0; k<nidx; k++)
+        (*index)[k] = seg->time[k * ARCHIVE_STRIDE];
+    for (uint32_t c=0; c<seg->columns; c++)
+    {
+        archive_summary_init(&column[c].total);
+        for (uint32_t r=0; r<seg->rows; r++)
+            archive_summary_add(&column[c].total, archive_value(seg->data[c] + (size_t)r * column[c].size, column[c].type));
+    }
+
+    char tmp[ARCHIVE_PATH + 8];
+    snprintf(tmp, sizeof(tmp), "%s.tmp", path);
+    FILE *f = fopen(tmp, "wb");
+    if (f == NULL) return false;
+    bool ok = (fwrite(&header, sizeof(header), 1, f) == 1);
+    ok = ok && (fwrite(column, sizeof(archive_column), seg->columns, f) == seg->columns);
+    ok = ok && (fwrite(*index, sizeof(int64_t), nidx, f) == nidx);
+    ok = ok && (fwrite(seg->time, sizeof(int64_t), seg->rows, f) == seg->rows);
+    for (uint32_t c=0; c<seg->columns; c++)
+        ok = ok && (fwrite(seg->data[c], column[c].size, seg->rows, f) == seg->rows);
+    for (uint32_t c=0; c<seg->columns; c++)
+    {
+        for (uint32_t k=0; k<nidx; k++)
+        {
+            archive_summary_init(&summary[k]);
+            uint32_t end = (k + 1) * ARCHIVE_STRIDE;
+            if (end > seg->rows) end = seg->rows;
+            for (uint32_t r=k*ARCHIVE_STRIDE; r<end; r++)
+                archive_summary_add(&summary[k], archive_value(seg->data[c] + (size_t)r * column[c].size, column[c].type));
+        }
+        ok = ok && (fwrite(summary, sizeof(archive_summary), nidx, f) == nidx);
+    }
+    free(summary);
+    ok = ok && (fflush(f) == 0) && (fsync(fileno(f)) == 0);
+    ok = (fclose(f) == 0) && ok;
+    ok = ok && (rename(tmp, path) == 0);
+    if (!ok) unlink(tmp);
+    return ok;
+}
+
+// Returns NULL if the file can not be loaded. Files with a different
+// version or an inconsistent layout are reported as invalid.
+static archive_segment *load_segment(const char *path, bool *invalid)
+{
+    *invalid = false;
+    int fd = open(path, O_RDONLY);
+    if (fd == -1) return NULL;
+    archive_segment *seg = (archive_segment *) calloc(1, sizeof(archive_segment));
+    archive_header header;
+    struct stat st;
+    if ((seg == NULL) || (fstat(fd, &st) != 0))
+    {
+        close(fd);
+        free(seg);
+        return NULL;
+    }
+    bool ok = (pread(fd, &header, sizeof(header), 0) == sizeof(header)) &&
+              (header.magic == ARCHIVE_MAGIC) && (header.version == ARCHIVE_VERSION) &&
+              (header.series < ARCHIVE_SERIES) && (header.columns <= ARCHIVE_COLUMNS) &&
+              (header.stride > 0) && (header.rows > 0);
+    if (ok)
+    {
+        size_t csize = header.columns * sizeof(archive_column);
+        uint32_t nidx = (header.rows + header.stride - 1) / header.stride;
+        seg->index = (int64_t *) malloc(nidx * sizeof(int64_t));
+        if (seg->index == NULL)
+        {
+            close(fd);
+            segment_free(seg);
+            return NULL;
+        }
+        ok = (pread(fd, seg->column, csize, sizeof(header)) == (ssize_t)csize) &&
+             (pread(fd, seg->index, nidx * sizeof(int64_t), header.index_offset) == (ssize_t)(nidx * sizeof(int64_t)));
+        for (uint32_t c=0; ok && (c<header.columns); c++)
+        {
+            seg->column[c].name[ARCHIVE_NAME-1] = 0;
+            ok = (seg->column[c].offset + (uint64_t)header.rows * seg->column[c].size <= (uint64_t)st.st_size) &&
+                 (seg->column[c].summary + nidx * sizeof(archive_summary) <= (uint64_t)st.st_size);
+        }
+    }
+    close(fd);
+    if (!ok)
+    {
+        segment_free(seg);
+        *invalid = true;
+        return NULL;
+    }
+    seg->state = SEGMENT_FILE;
+    seg->series = header.series;
+    seg->first_time = header.first_time;
+    seg->last_time = header.last_time;
+    seg->rows = header.rows;
+    seg->columns = header.columns;
+    seg->stride = header.stride;
+    seg->time_offset = header.time_offset;
+    seg->file_size = st.st_size;
+    snprintf(seg->path, ARCHIVE_PATH, "%s", path);
+    return seg;
+}
+
+static int compare_segments(const void *a, const void *b)
+{
+    const archive_segment *sa = *(archive_segment * const *)a;
+    const archive_segment *sb = *(archive_segment * const *)b;
+    return (sa->first_time > sb->first_time) - (sa->first_time < sb->first_time);
+}
+
+// true if the oldest segment of the series is a file
+static bool oldest_is_file(const archive_series *ser)
+{
+    return (ser->segment_count > 0) && (ser->segments[0]->state == SEGMENT_FILE);
+}
+
+// delete the oldest file of the series and return its size
+static uint64_t delete_oldest(archive_series *ser)
+{
+    uint64_t size = ser->segments[0]->file_size;
+    if (unlink(ser->segments[0]->path) != 0)
+        printf("OpcUaServer : failed to delete %s\n", ser->segments[0]->path);
+    list_remove(ser, 0);
+    return size;
+}
+
+// Delete the files exceeding the retention limits, archive_lock must be held.
+// The size limit applies to all series together, the oldest file is deleted first.
+static void apply_retention()
+{
+    UA_DateTime min_time = (archive_retention_days > 0) ?
+        UA_DateTime_now() - (UA_DateTime)archive_retention_days * 86400 * UA_DATETIME_SEC : 0;
+    for (int s=0; s<ARCHIVE_SERIES; s++)
+        while (oldest_is_file(&series[s]) && (series[s].segments[0]->last_time < min_time))
+            delete_oldest(&series[s]);
+    uint64_t total = 0;
+    int files = 0;
+    for (int s=0; s<ARCHIVE_SERIES; s++)
+        for (int i=0; i<series[s].segment_count; i++)
+            if (series[s].segments[i]->state == SEGMENT_FILE)
+            {
+                total += series[s].segments[i]->file_size;
+                files++;
+            }
+    uint64_t max_size = (archive_retention_mb > 0) ? (uint64_t)archive_retention_mb * 1048576 : UINT64_MAX;
+    while (total > max_size)
+    {
+        archive_series *oldest = NULL;
+        for (int s=0; s<ARCHIVE_SERIES; s++)
+            if (oldest_is_file(&series[s]) &&
+                ((oldest == NULL) || (series[s].segments[0]->first_time < oldest->segments[0]->first_time)))
+                oldest = &series[s];
+        if (oldest == NULL) break;
+        total -= delete_oldest(oldest);
+        files--;
+    }
+    archive_segments = files;
+    archive_size_mb = (float)total / 1048576.0f;
+}
+
+void archive_open(const char *dir)
+{
+    if (snprintf(archive_dir, ARCHIVE_DIR_LENGTH, "%s", dir) >= ARCHIVE_DIR_LENGTH)
+    {
+        printf("OpcUaServer : the archive directory name %s is too long\n", dir);
+        return;
+    }
+    mkdir(dir, 0755);
+    DIR *d = opendir(dir);
+    if (d == NULL)
+    {
+        printf("OpcUaServer : failed to open the archive directory %s\n", dir);
+        return;
+    }
+    struct dirent *e;
+    char path[ARCHIVE_PATH];
+    while ((e = readdir(d)) != NULL)
+    {
+        size_t len = strlen(e->d_name);
+        if (strncmp(e->d_name, "seg_", 4) != 0) continue;
+        if (snprintf(path, ARCHIVE_PATH, "%s/%s", archive_dir, e->d_name) >= ARCHIVE_PATH) continue;
+        // remove files left over from an interrupted write
+        if ((len > 4) && (strcmp(e->d_name + len - 4, ".tmp") == 0))
+        {
+            unlink(path);
+            continue;
+        }
+        if ((len < 4) || (strcmp(e->d_name + len - 4, ".dat") != 0)) continue;
+        bool invalid;
+        archive_segment *seg = load_segment(path, &invalid);
+        if (seg == NULL)
+        {
+            // files that can never be read would not be subject to the retention
+            if (invalid)
+            {
+                printf("OpcUaServer : archive segment %s is invalid and removed\n", path);
+                unlink(path);
+                archive_errors++;
+            }
+            continue;
+        }
+        if (!list_append(&series[seg->series], seg)) segment_free(seg);
+    }
+    closedir(d);
+    pthread_mutex_lock(&archive_lock);
+    for (int s=0; s<ARCHIVE_SERIES; s++)
+    {
+        archive_series *ser = &series[s];
+        if (ser->segment_count == 0) continue;
+        qsort(ser->segments, ser->segment_count, sizeof(archive_segment *), compare_segments);
+        ser->last_time = ser->segments[ser->segment_count-1]->last_time;
+    }
+    apply_retention();
+    archive_opened = true;
+    pthread_mutex_unlock(&archive_lock);
+    printf("OpcUaServer : archive %s with %d segments\n", dir, archive_segments);
+}
+
+// write all pending segments
+static void write_pending()
+{
+    while (true)
+    {
+        archive_series *ser = NULL;
+        archive_segment *seg = NULL;
+        pthread_mutex_lock(&archive_lock);
+        for (int s=0; (s<ARCHIVE_SERIES) && (seg == NULL); s++)
+            for (int i=0; i<series[s].segment_count; i++)
+                if (series[s].segments[i]->state == SEGMENT_PENDING)
+                {
+                    ser = &series[s];
+                    seg = ser->segments[i];
+                    break;
+                }
+        pthread_mutex_unlock(&archive_lock);
+        if (seg == NULL) return;
+
+        char path[ARCHIVE_PATH];
+        archive_header header;
+        archive_column column[ARCHIVE_COLUMNS];
+        int64_t *index = NULL;
+        bool ok = write_segment(seg, path, &header, column, &index);
+
+        pthread_mutex_lock(&archive_lock);
+        int i = 0;
+        while ((i < ser->segment_count) && (ser->segments[i] != seg)) i++;
+        if (!ok)
+        {
+            printf("OpcUaServer : failed to write the archive segment %s\n", path);
+            archive_errors++;
+            free(index);
+            list_remove(ser, i);
+        }
+        else
+        {
+            // from now on the segment is read from the file
+            for (uint32_t c=0; c<seg->columns; c++)
+            {
+                free(seg->data[c]);
+                seg->data[c] = NULL;
+            }
+            free(seg->time);
+            seg->time = NULL;
+            memcpy(seg->column, column, seg->columns * sizeof(archive_column));
+            seg->index = index;
+            seg->stride = header.stride;
+            seg->time_offset = header.time_offset;
+            seg->file_size = header.size;
+            snprintf(seg->path, ARCHIVE_PATH, "%s", path);
+            seg->state = SEGMENT_FILE;
+        }
+        pthread_mutex_unlock(&archive_lock);
+    }
+}
+
+void archive_update()
+{
+    if (!archive_opened) return;
+    sample_device();
+    write_pending();
+    pthread_mutex_lock(&archive_lock);
+    apply_retention();
+    pthread_mutex_unlock(&archive_lock);
+}
+
+void archive_close()
+{
+    if (!archive_opened) return;
+    pthread_mutex_lock(&archive_lock);
+    for (int s=0; s<ARCHIVE_SERIES; s++)
+    {
+        archive_series *ser = &series[s];
+        if ((ser->segment_count > 0) && (ser->segments[ser->segment_count-1]->state == SEGMENT_CURRENT))
+            ser->segments[ser->segment_count-1]->state = SEGMENT_PENDING;
+    }
+    pthread_mutex_unlock(&archive_lock);
+    write_pending();
+    pthread_mutex_lock(&archive_lock);
+    archive_opened = false;
+    for (int s=0; s<ARCHIVE_SERIES; s++)
+        while (series[s].segment_count > 0)
+            list_remove(&series[s], series[s].segment_count - 1);
+    pthread_mutex_unlock(&archive_lock);
+}
+
+/***********************************/
+/* queries                         */
+/***********************************/
+
+static bool column_matches(const archive_column *col, const UA_NodeId *id, const UA_DataType *type)
+{
+    return (id->identifierType == UA_NODEIDTYPE_STRING) &&
+           (id->identifier.string.length == strlen(col->name)) &&
+           (memcmp(id->identifier.string.data, col->name, id->identifier.string.length) == 0) &&
+           ((type == NULL) || ((col->size == type->memSize) && (col->type == type->typeId.identifier.numeric)));
+}
+
+static int find_column(const archive_segment *seg, const UA_NodeId *id, const UA_DataType *type)
+{
+    for (uint32_t c=0; c<seg->columns; c++)
+        if (column_matches(&seg->column[c], id, type)) return c;
+    return -1;
+}
+
+static bool series_holds(const archive_series *ser, const UA_NodeId *id, const UA_DataType *type)
+{
+    for (int s=0; s<ser->segment_count; s++)
+        if ((ser->segments[s]->rows > 0) && (find_column(ser->segments[s], id, type) >= 0)) return true;
+    return false;
+}
+
+static const archive_variable *find_variable(const UA_NodeId *id, int *s)
+{
+    for (*s=0; *s<ARCHIVE_SERIES; (*s)++)
+        for (int c=0; c<series[*s].variable_count; c++)
+        {
+            const archive_variable *var = &series[*s].variables[c];
+            if ((id->identifierType == UA_NODEIDTYPE_STRING) &&
+                (id->identifier.string.length == strlen(var->name)) &&
+                (memcmp(id->identifier.string.data, var->name, id->identifier.string.length) == 0))
+                return var;
+        }
+    return NULL;
+}
+
+// The series holding the variable, the one it is registered with
+// or the first one holding it in any segment. archive_lock must be held.
+static const archive_series *series_of(const UA_NodeId *id, const UA_DataType *type)
+{
+    int s;
+    if (find_variable(id, &s) != NULL) return &series[s];
+    for (s=0; s<ARCHIVE_SERIES; s++)
+        if (series_holds(&series[s], id, type)) return &series[s];
+    return NULL;
+}
+
+bool archive_covers(const UA_NodeId *id)
+{
+    pthread_mutex_lock(&archive_lock);
+    const archive_series *ser = series_of(id, NULL);
+    bool found = (ser != NULL) && series_holds(ser, id, NULL);
+    pthread_mutex_unlock(&archive_lock);
+    return found;
+}
+
+const UA_DataType *archive_type(const UA_NodeId *id)
+{
+    int s;
+    const archive_variable *var = find_variable(id, &s);
+    return (var != NULL) ? var->type : NULL;
+}
+
+// The queries work on a copy of the segment list of one series taken under
+// archive_lock and read the files without holding the lock, the stream
+// reader appending the pulses is never blocked by the file accesses.
+// Of the segments in memory the times and the requested column are copied.
+// Files deleted by the retention in the meantime are passed over.
+typedef struct {
+    bool file;
+    UA_DateTime first_time;
+    UA_DateTime last_time;
+    uint32_t rows;
+    bool has_column;                // the segment holds the requested variable
+    archive_column column;
+    // file
+    char path[ARCHIVE_PATH];
+    uint64_t time_offset;
+    uint32_t stride;
+    int64_t *index;
+    // in memory
+    int64_t *time;
+    char *data;
+} segment_view;
+
+typedef struct {
+    segment_view *segments;
+    int segment_count;
+} archive_view;
+
+static void view_free(archive_view *view)
+{
+    for (int s=0; s<view->segment_count; s++)
+    {
+        free(view->segments[s].index);
+        free(view->segments[s].time);
+        free(view->segments[s].data);
+    }
+    free(view->segments);
+    view->segments = NULL;
+    view->segment_count = 0;
+}
+
+// copy the segments of the series holding the variable with
+// last_time >= from and first_time < to
+static bool view_take(archive_view *view, const UA_NodeId *id, const UA_DataType *type,
+                      UA_DateTime from, UA_DateTime to)
+{
+    view->segments = NULL;
+    view->segment_count = 0;
+    bool ok = true;
+    pthread_mutex_lock(&archive_lock);
+    const archive_series *ser = series_of(id, type);
+    if ((ser != NULL) && (ser->segment_count > 0))
+    {
+        view->segments = (segment_view *) calloc(ser->segment_count, sizeof(segment_view));
+        ok = (view->segments != NULL);
+    }
+    for (int s=0; ok && (ser != NULL) && (s<ser->segment_count); s++)
+    {
+        const archive_segment *seg = ser->segments[s];
+        if ((seg->rows == 0) || (seg->last_time < from) || (seg->first_time >= to)) continue;
+        segment_view *v = &view->segments[view->segment_count++];
+        v->file = (seg->state == SEGMENT_FILE);
+        v->first_time = seg->first_time;
+        v->last_time = seg->last_time;
+        v->rows = seg->rows;
+        int col = find_column(seg, id, type);
+        v->has_column = (col >= 0) && (seg->column[col].size <= sizeof(UA_Double));
+        if (v->has_column) v->column = seg->column[col];
+        if (v->file)
+        {
+            uint32_t nidx = (seg->rows + seg->stride - 1) / seg->stride;
+            memcpy(v->path, seg->path, ARCHIVE_PATH);
+            v->time_offset = seg->time_offset;
+            v->stride = seg->stride;
+            v->index = (int64_t *) malloc(nidx * sizeof(int64_t));
+            ok = (v->index != NULL);
+            if (ok) memcpy(v->index, seg->index, nidx * sizeof(int64_t));
+        }
+        else
+        {
+            v->time = (int64_t *) malloc(seg->rows * sizeof(int64_t));
+            ok = (v->time != NULL);
+            if (ok) memcpy(v->time, seg->time, seg->rows * sizeof(int64_t));
+            if (ok && v->has_column)
+            {
+                v->data = (char *) malloc((size_t)seg->rows * v->column.size);
+                ok = (v->data != NULL);
+                if (ok) memcpy(v->data, seg->data[col], (size_t)seg->rows * v->column.size);
+            }
+        }
+    }
+    pthread_mutex_unlock(&archive_lock);
+    if (!ok) view_free(view);
+    return ok;
+}
+
+// open the file of a segment, a file deleted in the meantime is reported as gone
+static int view_open(const segment_view *seg, bool *gone)
+{
+    int fd = open(seg->path, O_RDONLY);
+    *gone = (fd == -1) && (errno == ENOENT);
+    return fd;
+}
+
+// A position within a view is given by the segment (index into the view)
+// and the row within that segment. Positions are kept normalized,
+// row < rows of the segment, the end of the view is (segment_count, 0).
+typedef struct {
+    int seg;
+    uint32_t row;
+} archive_cursor;
+
+static int cursor_compare(archive_cursor a, archive_cursor b)
+{
+    if (a.seg != b.seg) return (a.seg > b.seg) - (a.seg < b.seg);
+    return (a.row > b.row) - (a.row < b.row);
+}
+
+static bool time_before(UA_DateTime tm, UA_DateTime t, bool after)
+{
+    return (tm < t) || (after && (tm == t));
+}
+
+// The first row of a segment with a time >= t (after = false) or > t (after = true).
+// In files the block is located from the sparse index and only its times are read.
+static uint32_t segment_search(const segment_view *seg, UA_DateTime t, bool after)
+{
+    if (!seg->file)
+    {
+        uint32_t lo = 0, hi = seg->rows;
+        while (lo < hi)
+        {
+            uint32_t mid = lo + (hi - lo) / 2;
+            if (time_before(seg->time[mid], t, after)) lo = mid + 1; else hi = mid;
+        }
+        return lo;
+    }
+    uint32_t nidx = (seg->rows + seg->stride - 1) / seg->stride;
+    uint32_t lo = 0, hi = nidx;
+    while (lo < hi)
+    {
+        uint32_t mid = lo + (hi - lo) / 2;
+        if (time_before(seg->index[mid], t, after)) lo = mid + 1; else hi = mid;
+    }
+    if (lo == 0) return 0;
+    // the row is within the block lo-1 or the first of block lo
+    uint32_t base = (lo - 1) * seg->stride;
+    uint32_t n = seg->rows - base;
+    if (n > seg->stride) n = seg->stride;
+    int64_t times[n];
+    int fd = open(seg->path, O_RDONLY);
+    bool ok = (fd != -1) &&
+              (pread(fd, times, n * sizeof(int64_t), seg->time_offset + base * sizeof(int64_t)) == (ssize_t)(n * sizeof(int64_t)));
+    if (fd != -1) close(fd);
+    if (!ok) return base;
+    uint32_t l = 0, h = n;
+    while (l < h)
+    {
+        uint32_t mid = l + (h - l) / 2;
+        if (time_before(times[mid], t, after)) l = mid + 1; else h = mid;
+    }
+    return base + l;
+}
+
+// the first position with a time >= t (after = false) or > t (after = true)
+static archive_cursor locate(const archive_view *view, UA_DateTime t, bool after)
+{
+    archive_cursor c = { view->segment_count, 0 };
+    for (int s=0; s<view->segment_count; s++)
+    {
+        if (!time_before(view->segments[s].last_time, t, after))
+        {
+            c.seg = s;
+            c.row = segment_search(&view->segments[s], t, after);
+            break;
+        }
+    }
+    return c;
+}
+
+static archive_cursor normalize(const archive_view *view, archive_cursor c)
+{
+    while ((c.seg < view->segment_count) && (c.row >= view->segments[c.seg].rows))
+    {
+        c.seg++;
+        c.row = 0;
+    }
+    if (c.seg >= view->segment_count)
+    {
+        c.seg = view->segment_count;
+        c.row = 0;
+    }
+    return c;
+}
+
+// number of rows from lo up to (excluding) hi
+static uint64_t rows_between(const archive_view *view, archive_cursor lo, archive_cursor hi)
+{
+    if (cursor_compare(lo, hi) >= 0) return 0;
+    if (lo.seg == hi.seg) return hi.row - lo.row;
+    uint64_t n = view->segments[lo.seg].rows - lo.row;
+    for (int s=lo.seg+1; s<hi.seg; s++)
+        n += view->segments[s].rows;
+    return n + hi.row;
+}
+
+// read the times and values of the rows [row, row+n) of a segment
+static bool read_rows(const segment_view *seg, int fd, uint32_t row, uint32_t n, int64_t *times, char *values)
+{
+    size_t size = seg->column.size;
+    if (!seg->file)
+    {
+        memcpy(times, &seg->time[row], n * sizeof(int64_t));
+        memcpy(values, seg->data + row * size, n * size);
+        return true;
+    }
+    return (pread(fd, times, n * sizeof(int64_t), seg->time_offset + (uint64_t)row * sizeof(int64_t)) == (ssize_t)(n * sizeof(int64_t))) &&
+           (pread(fd, values, n * size, seg->column.offset + (uint64_t)row * size) == (ssize_t)(n * size));
+}
+
+static void set_value(UA_DataValue *dv, const void *value, UA_DateTime time,
+                      const UA_DataType *type, UA_TimestampsToReturn timestampsToReturn)
+{
+    UA_Variant_setScalarCopy(&dv->value, value, type);
+    dv->hasValue = true;
+    if ((timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE) || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH))
+    {
+        dv->sourceTimestamp = time;
+        dv->hasSourceTimestamp = true;
+    }
+    if ((timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER) || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH))
+    {
+        dv->serverTimestamp = time;
+        dv->hasServerTimestamp = true;
+    }
+}
+
+// The continuation point holds the first time of the segment and the row
+// of the next position. Forward the values are returned from that position on,
+// reverse the values before that position.
+UA_StatusCode archive_read(
+    UA_Server *server,
+    const UA_NodeId *id,
+    const UA_DataType *type,
+    const UA_ReadRawModifiedDetails *details,
+    UA_TimestampsToReturn timestampsToReturn,
+    const UA_ByteString *continuationPoint,
+    UA_HistoryReadResult *result,
+    UA_HistoryData *data)
+{
+    UA_DateTime start = details->startTime;
+    UA_DateTime end = details->endTime;
+    if ((start == 0) && (end == 0)) return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if (((start == 0) || (end == 0)) && (details->numValuesPerNode == 0))
+        return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if (details->returnBounds) return UA_STATUSCODE_BADBOUNDNOTSUPPORTED;
+    if ((continuationPoint->length != 0) && (continuationPoint->length != ARCHIVE_CONTINUATION))
+        return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+
+    archive_view view;
+    if (!view_take(&view, id, type, UA_INT64_MIN, UA_INT64_MAX)) return UA_STATUSCODE_BADOUTOFMEMORY;
+    // forward : start <= t < end, reverse : end < t <= start
+    // the rows [lo, hi) are returned in ascending or descending order
+    bool reverse = (start == 0) || ((end != 0) && (start > end));
+    archive_cursor lo, hi;
+    archive_cursor first = { 0, 0 };
+    archive_cursor last = { view.segment_count, 0 };
+    if (!reverse)
+    {
+        lo = locate(&view, start, false);
+        hi = (end == 0) ? last : locate(&view, end, false);
+    }
+    else
+    {
+        hi = locate(&view, (start == 0) ? end : start, true);
+        lo = ((start == 0) || (end == 0)) ? first : locate(&view, end, true);
+    }
+
+    // continue a previous request, segments deleted in the meantime are skipped
+    if (continuationPoint->length > 0)
+    {
+        int64_t cp[2];
+        memcpy(cp, continuationPoint->data, sizeof(cp));
+        archive_cursor c = { view.segment_count, 0 };
+        for (int s=0; s<view.segment_count; s++)
+            if (view.segments[s].first_time >= cp[0])
+            {
+                c.seg = s;
+                c.row = (view.segments[s].first_time == cp[0]) ? (uint32_t)cp[1] : 0;
+                break;
+            }
+        c = normalize(&view, c);
+        if (reverse) hi = c; else lo = c;
+    }
+
+    uint64_t available = rows_between(&view, lo, hi);
+    uint64_t n = available;
+    UA_UInt32 max = details->numValuesPerNode;
+    UA_UInt32 server_max = UA_Server_getConfig(server)->maxReturnDataValues;
+    if ((server_max > 0) && ((max == 0) || (server_max < max))) max = server_max;
+    if ((max == 0) || (max > ARCHIVE_MAX_RETURN)) max = ARCHIVE_MAX_RETURN;
+    if (n > max) n = max;
+
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    if (n > 0)
+    {
+        data->dataValues = (UA_DataValue *) UA_Array_new(n, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if (data->dataValues == NULL) retval = UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+
+    // Walk through the rows block by block. Segments without the column
+    // (written with a different set of variables) are passed over.
+    size_t count = 0;
+    uint64_t done = 0;
+    archive_cursor pos = reverse ? hi : lo;
+    int64_t times[ARCHIVE_STRIDE];
+    char values[ARCHIVE_STRIDE * sizeof(UA_Double)];
+    int fd = -1;
+    int fd_seg = -1;                // the segment of the open file
+    bool gone = false;              // the file of that segment was deleted
+    while ((retval == UA_STATUSCODE_GOOD) && (done < n))
+    {
+        // the block [a, a+k) within segment s
+        int s;
+        uint32_t a, k;
+        if (!reverse)
+        {
+            s = pos.seg;
+            a = pos.row;
+            k = view.segments[s].rows - a;
+        }
+        else
+        {
+            if (pos.row == 0)
+            {
+                pos.seg--;
+                pos.row = view.segments[pos.seg].rows;
+            }
+            s = pos.seg;
+            k = pos.row;
+            a = 0;
+        }
+        if (k > ARCHIVE_STRIDE) k = ARCHIVE_STRIDE;
+        if (k > n - done) k = n - done;
+        if (reverse) a = pos.row - k;
+
+        const segment_view *seg = &view.segments[s];
+        if (seg->has_column && seg->file && (fd_seg != s))
+        {
+            if (fd != -1) close(fd);
+            fd = view_open(seg, &gone);
+            fd_seg = s;
+        }
+        if (seg->has_column && !(seg->file && gone))
+        {
+            if ((seg->file && (fd == -1)) || !read_rows(seg, fd, a, k, times, values))
+            {
+                printf("OpcUaServer : failed to read the archive segment %s\n", seg->path);
+                retval = UA_STATUSCODE_BADINTERNALERROR;
+                break;
+            }
+            for (uint32_t i=0; i<k; i++)
+            {
+                uint32_t r = reverse ? k - 1 - i : i;
+                set_value(&data->dataValues[count++], values + r * seg->column.size,
+                          times[r], type, timestampsToReturn);
+            }
+        }
+        done += k;
+        if (reverse)
+            pos.row = a;
+        else
+        {
+            pos.row = a + k;
+            pos = normalize(&view, pos);
+        }
+    }
+    if (fd != -1) close(fd);
+    if ((retval == UA_STATUSCODE_GOOD) && (n < available))
+    {
+        // more data available
+        int64_t cp[2];
+        cp[0] = (pos.seg < view.segment_count) ? view.segments[pos.seg].first_time : 0;
+        cp[1] = pos.row;
+        retval = UA_ByteString_allocBuffer(&result->continuationPoint, ARCHIVE_CONTINUATION);
+        if (retval == UA_STATUSCODE_GOOD)
+            memcpy(result->continuationPoint.data, cp, ARCHIVE_CONTINUATION);
+    }
+    view_free(&view);
+
+    if (retval != UA_STATUSCODE_GOOD)
+    {
+        UA_Array_delete(data->dataValues, n, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        data->dataValues = NULL;
+        return retval;
+    }
+    data->dataValuesSize = count;
+    if (count == 0)
+    {
+        UA_Array_delete(data->dataValues, n, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        data->dataValues = NULL;
+        return UA_STATUSCODE_GOODNODATA;
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+/***********************************/
+/* aggregates                      */
+/***********************************/
+
+// add the rows [a, b) of a segment to the summary reading them block by block
+static bool aggregate_rows(const segment_view *seg, int fd, uint32_t a, uint32_t b, archive_summary *summary)
+{
+    int64_t times[ARCHIVE_STRIDE];
+    char values[ARCHIVE_STRIDE * sizeof(UA_Double)];
+    size_t size = seg->column.size;
+    while (a < b)
+    {
+        uint32_t k = b - a;
+        if (k > ARCHIVE_STRIDE) k = ARCHIVE_STRIDE;
+        if (!read_rows(seg, fd, a, k, times, values)) return false;
+        for (uint32_t i=0; i<k; i++)
+            archive_summary_add(summary, archive_value(values + i * size, seg->column.type));
+        a += k;
+    }
+    return true;
+}
+
+// Segments lying completely within the interval contribute their total.
+// Of the segments at the edges of the interval the summaries of the
+// complete blocks are used and only the remaining rows are read.
+UA_StatusCode archive_aggregate(
+    const UA_NodeId *id,
+    const UA_DataType *type,
+    UA_DateTime from,
+    UA_DateTime to,
+    archive_summary *summary)
+{
+    archive_view view;
+    if (!view_take(&view, id, type, from, to)) return UA_STATUSCODE_BADOUTOFMEMORY;
+    UA_StatusCode retval = UA_STATUSCODE_GOOD;
+    for (int s=0; (s<view.segment_count) && (retval == UA_STATUSCODE_GOOD); s++)
+    {
+        const segment_view *seg = &view.segments[s];
+        if (!seg->has_column) continue;
+        bool all = (seg->first_time >= from) && (seg->last_time < to);
+        if (all && seg->file)
+        {
+            archive_summary_merge(summary, &seg->column.total);
+            continue;
+        }
+        uint32_t a = all ? 0 : segment_search(seg, from, false);
+        uint32_t b = all ? seg->rows : segment_search(seg, to, false);
+        if (a >= b) continue;
+        if (!seg->file)
+        {
+            aggregate_rows(seg, -1, a, b, summary);
+            continue;
+        }
+        // the complete blocks [ka, kb) within the rows [a, b)
+        uint32_t stride = seg->stride;
+        uint32_t ka = (a + stride - 1) / stride;
+        uint32_t kb = (b == seg->rows) ? (seg->rows + stride - 1) / stride : b / stride;
+        bool gone;
+        int fd = view_open(seg, &gone);
+        if (gone) continue;
+        bool ok = (fd != -1);
+        if (ok && (ka < kb))
+        {
+            uint32_t n = kb - ka;
+            archive_summary *blocks = (archive_summary *) malloc(n * sizeof(archive_summary));
+            ok = (blocks != NULL) &&
+                 (pread(fd, blocks, n * sizeof(archive_summary), seg->column.summary + ka * sizeof(archive_summary)) == (ssize_t)(n * sizeof(archive_summary)));
+            for (uint32_t k=0; ok && (k<n); k++)
+                archive_summary_merge(summary, &blocks[k]);
+            free(blocks);
+            uint32_t end = (kb * stride > seg->rows) ? seg->rows : kb * stride;
+            ok = ok && aggregate_rows(seg, fd, a, ka * stride, summary) &&
+                 aggregate_rows(seg, fd, end, b, summary);
+        }
+        else if (ok)
+            ok = aggregate_rows(seg, fd, a, b, summary);
+        if (fd != -1) close(fd);
+        if (!ok)
+        {
+            printf("OpcUaServer : failed to read the archive segment %s\n", seg->path);
+            retval = UA_STATUSCODE_BADINTERNALERROR;
+        }
+    }
+    view_free(&view);
+    return retval;
+}
@@ -0,0 +1,188 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_archive.h
+  OpcUaServer : on-disk archive of the historized stream variables
+  Version 0.2 2026/10/19
+
+  The archive holds two series of rows in segment files in ARCHIVE_DIR.
+  SERIES_PULSE holds the values of the push variables (pulse_push.h),
+  one row for every accepted pulse, recorded by the stream reader thread
+  independent of the rate at which the push variables are written.
+  SERIES_DEVICE holds the settings of the device read through MCI,
+  sampled once every second and recorded whenever any of them changed.
+
+  A segment holds up to archive_segment_rows rows of one series stored by
+  column : the header, one descriptor per column, a sparse time index holding
+  the time of every ARCHIVE_STRIDE-th row, the time column and one column
+  per variable. A query locates the segments from their time ranges,
+  the rows within a segment from the sparse index and only reads the
+  times and the column of the requested variable.
+
+  Full segments are written by the timer thread, which also deletes the
+  oldest segments when the archive exceeds archive_retention_mb or
+  archive_retention_days. Segment files which can not be read (an other
+  version of the file format, a damaged file) are removed when the archive
+  is opened and counted in archive_errors.
+
+  HistoryReadRaw requests reaching beyond the in-memory history (pulse_hdb.h)
+  are served from the archive, including the rows not yet written to disk.
+  The history of the device variables is only held in the archive.
+  A query copies the segment list under the lock and reads the files
+  without holding it, appending rows is never delayed by the file accesses.
+
+  Every segment file also holds partial aggregates (count, mean, variance,
+  minimum, maximum) of every column, for the whole segment and for every
+  block of ARCHIVE_STRIDE rows. Aggregates over a time interval are combined
+  from these summaries, only the rows at the edges of the interval are read.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEARCHIVE_H
+#define PULSEARCHIVE_H
+
+#include "pulse_snapshot.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define ARCHIVE_DIR "/var/tmp/opcua_server_archive"
+
+// the series of the archive
+#define ARCHIVE_SERIES 2
+#define SERIES_PULSE 0
+#define SERIES_DEVICE 1
+
+// maximum number of archived variables per series
+#define ARCHIVE_COLUMNS 64
+// rows per entry of the sparse time index
+#define ARCHIVE_STRIDE 256
+// maximum number of full segments waiting to be written
+#define ARCHIVE_PENDING 4
+// maximum number of values returned by one HistoryRead without a limit
+#define ARCHIVE_MAX_RETURN 65536
+// size of the continuation points of the archive
+#define ARCHIVE_CONTINUATION 16
+
+// Partial aggregate of a set of values. The mean and the sum of the squared
+// deviations are updated incrementally, two summaries can be merged.
+typedef struct {
+    uint64_t count;
+    double mean;
+    double m2;                  // sum of the squared deviations from the mean
+    double min;
+    double max;
+} archive_summary;
+
+void archive_summary_init(archive_summary *s);
+void archive_summary_add(archive_summary *s, double x);
+void archive_summary_merge(archive_summary *s, const archive_summary *t);
+
+// the value of a numeric scalar, type is the numeric node id of its data type
+double archive_value(const void *value, uint32_t type);
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t archive_enable;          // 0=off 1=on
+extern int32_t archive_segment_rows;    // rows per segment, used for the next segment
+extern int32_t archive_retention_mb;    // maximum size of all segments [MB]
+extern int32_t archive_retention_days;  // maximum age of the segments [d]
+
+//*************************************
+// results
+//*************************************
+
+extern int32_t archive_segments;        // number of segment files
+extern float archive_size_mb;           // size of all segment files [MB]
+extern uint32_t archive_dropped;        // rows lost because the writer fell behind
+extern uint32_t archive_errors;         // failed writes and removed invalid segment files
+
+// the read function of a data source variable
+typedef UA_StatusCode (*archive_read_function)(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+// register a variable to be archived with every pulse
+// name is the string node id, var points to the value in stream_snapshot
+void archive_register(const char *name, const void *var, const UA_DataType *type);
+
+// register a device variable to be archived, read is called from the timer thread
+void archive_register_device(const char *name, archive_read_function read, const UA_DataType *type);
+
+// read the existing segments from the directory
+// no rows are recorded before, all variables must be registered
+void archive_open(const char *dir);
+
+// write the data held in memory
+void archive_close();
+
+// append one row for every state - called by the stream reader thread
+void archive_process(const pulse_snapshot *states, int count);
+
+// to be called once every second from the timer thread
+// samples the device variables, writes the full segments
+// and applies the retention limits
+void archive_update();
+
+// true if the variable is archived and the archive holds any data
+bool archive_covers(const UA_NodeId *id);
+
+// the data type of an archived variable, NULL if it is not archived
+const UA_DataType *archive_type(const UA_NodeId *id);
+
+// HistoryReadRaw of one variable from the archive
+// continues with continuationPoint if it is not empty
+UA_StatusCode archive_read(
+    UA_Server *server,
+    const UA_NodeId *id,
+    const UA_DataType *type,
+    const UA_ReadRawModifiedDetails *details,
+    UA_TimestampsToReturn timestampsToReturn,
+    const UA_ByteString *continuationPoint,
+    UA_HistoryReadResult *result,
+    UA_HistoryData *data);
+
+// add all archived values of the variable with from <= t < to to the summary
+UA_StatusCode archive_aggregate(
+    const UA_NodeId *id,
+    const UA_DataType *type,
+    UA_DateTime from,
+    UA_DateTime to,
+    archive_summary *summary);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,197 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_burst.c
+  OpcUaServer : macro-pulse (burst) detection
+  Version 0.2 2026/10/19
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "pulse_burst.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t burst_gap = 1000;
+int32_t burst_min_pulses = 2;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+burst_result burst_last;
+
+// the published record, written under the lock when a burst is closed
+static burst_result result;
+
+/***********************************/
+/* the burst being collected       */
+/***********************************/
+
+static bool open_burst = false;
+static int64_t first_time;              // ingest times [ns]
+static int64_t last_time;
+static int32_t pulses;
+static int64_t sums[PULSE_CHANNELS];
+// start of the last burst that was published
+static int64_t previous_start = 0;
+
+// the burst is extended by the stream reader thread
+// and may be closed by the timer thread
+static pthread_mutex_t burst_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void close_burst()
+{
+    open_burst = false;
+    if (pulses < burst_min_pulses) return;
+    double duration = (double)(last_time - first_time);
+    result.pulses = pulses;
+    result.duration = (float)(duration * 1e-3);
+    result.rate = (duration > 0.0) ? (float)((pulses - 1) / (duration * 1e-9)) : 0.0f;
+    result.interval = (previous_start > 0) ? (float)((first_time - previous_start) * 1e-6) : 0.0f;
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        result.sum[ch] = (double)sums[ch];
+        result.mean[ch] = (float)((double)sums[ch] / pulses);
+    }
+    previous_start = first_time;
+    result.count++;
+}
+
+void burst_process(const pulse_data *blocks, const pulse_info *info, int count)
+{
+    int64_t gap = (int64_t)burst_gap * 1000;
+    pthread_mutex_lock(&burst_lock);
+    for (int k=0; k<count; k++)
+    {
+        int64_t t = info[k].timestamp;
+        if (open_burst && (t - last_time > gap))
+            close_burst();
+        if (!open_burst)
+        {
+            open_burst = true;
+            first_time = t;
+            pulses = 0;
+            for (int ch=0; ch<PULSE_CHANNELS; ch++) sums[ch] = 0;
+        }
+        last_time = t;
+        pulses++;
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+            sums[ch] += PULSE_VALUE(&blocks[k], ch, FIELD_SUM);
+    }
+    // also picks up a burst closed by the timer thread
+    burst_last = result;
+    pthread_mutex_unlock(&burst_lock);
+}
+
+void burst_update()
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    int64_t t = (int64_t)now.tv_sec * 1000000000 + now.tv_nsec;
+    pthread_mutex_lock(&burst_lock);
+    if (open_burst && (t - last_time > (int64_t)burst_gap * 1000))
+        close_burst();
+    pthread_mutex_unlock(&burst_lock);
+}
+
+/***********************************/
+/* the copy served to the clients  */
+/***********************************/
+
+// only accessed by the server thread
+static burst_result copy;
+static bool copy_valid = false;
+
+void burst_invalidate()
+{
+    copy_valid = false;
+}
+
+// the field of the copy at the position of var within burst_last
+static const void *burst_take(const void *var)
+{
+    if (!copy_valid)
+    {
+        pthread_mutex_lock(&burst_lock);
+        copy = result;
+        pthread_mutex_unlock(&burst_lock);
+        copy_valid = true;
+    }
+    return (const char *)&copy + ((const char *)var - (const char *)&burst_last);
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_burst_Int32(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    if (nodeContext == NULL) return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    UA_Variant_setScalarCopy(&dataValue->value, burst_take(nodeContext), &UA_TYPES[UA_TYPES_INT32]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode read_burst_Float(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    if (nodeContext == NULL) return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    UA_Variant_setScalarCopy(&dataValue->value, burst_take(nodeContext), &UA_TYPES[UA_TYPES_FLOAT]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode read_burst_Double(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    if (nodeContext == NULL) return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    UA_Variant_setScalarCopy(&dataValue->value, burst_take(nodeContext), &UA_TYPES[UA_TYPES_DOUBLE]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
@@ -0,0 +1,124 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_burst.h
+  OpcUaServer : macro-pulse (burst) detection
+  Version 0.2 2026/10/19
+
+  Consecutive pulses belong to the same burst as long as the gap between
+  their ingest times does not exceed burst_gap. A burst is closed by
+  the first pulse after a longer gap or by the timer if no further pulse
+  arrives. Bursts with less than burst_min_pulses pulses are ignored.
+  The statistics are computed once when the burst is closed.
+
+  The ingest time is taken when the block is read from the stream,
+  gaps much shorter than the reader latency can not be resolved.
+
+  The results of a closed burst are published as one record under a lock.
+  The server reads them from a copy of the record taken with the first read
+  in every iteration of the server main loop (like the stream snapshot in
+  pulse_snapshot.h), so all results of one request belong to the same burst.
+  The stream reader takes its own copy burst_last with every batch, which
+  is recorded in the history database.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEBURST_H
+#define PULSEBURST_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t burst_gap;               // largest gap within a burst [us]
+extern int32_t burst_min_pulses;        // smallest number of pulses in a burst
+
+//*************************************
+// results of the last complete burst
+//*************************************
+
+typedef struct {
+    int32_t count;                      // number of bursts detected
+    int32_t pulses;                     // number of pulses
+    float duration;                     // time from the first to the last pulse [us]
+    float rate;                         // intra-burst pulse rate [pulses/s]
+    float interval;                     // time since the start of the previous burst [ms]
+    double sum[PULSE_CHANNELS];         // sum of Ch*_sum over the burst
+    float mean[PULSE_CHANNELS];         // mean of Ch*_sum over the burst
+} burst_result;
+
+// the copy of the stream reader thread, the node context of the result variables
+extern burst_result burst_last;
+
+// assign a batch of data blocks to bursts
+void burst_process(const pulse_data *blocks, const pulse_info *info, int count);
+
+// to be called once every second from the timer thread
+// closes a burst if no pulse has arrived for longer than the gap
+void burst_update();
+
+// to be called by the server main loop before every iteration
+void burst_invalidate();
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// read one result, nodeContext points to the field within burst_last
+UA_StatusCode read_burst_Int32(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+UA_StatusCode read_burst_Float(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+UA_StatusCode read_burst_Double(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,150 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_calibration.c
+  OpcUaServer : calibrated pulse data
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "libera_mci.h"      // the MCI access layer
+#include "pulse_calibration.h"
+
+float calibration_scale[PULSE_CHANNELS] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+/***********************************/
+/* cached instrument settings      */
+/***********************************/
+
+typedef struct {
+    int32_t offset[PULSE_CHANNELS];
+    uint32_t attenuation[PULSE_CHANNELS];
+    uint32_t samples;
+} calibration_settings;
+
+// the settings last read from MCI and the gain factors derived from the attenuation
+static calibration_settings cached;
+static float attenuation_gain[PULSE_CHANNELS] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+// the cache is written by the timer thread and read by the stream reader thread
+static pthread_mutex_t calibration_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static volatile bool calibration_stale = true;
+static int seconds_since_check = 0;
+
+bool calibration_refresh()
+{
+    calibration_settings s;
+    uint32_t pre, post;
+    bool success = true;
+    success &= mci_get_offs_ch1(&s.offset[0]);
+    success &= mci_get_offs_ch2(&s.offset[1]);
+    success &= mci_get_offs_ch3(&s.offset[2]);
+    success &= mci_get_offs_ch4(&s.offset[3]);
+    success &= mci_get_attenuation_ch1(&s.attenuation[0]);
+    success &= mci_get_attenuation_ch2(&s.attenuation[1]);
+    success &= mci_get_attenuation_ch3(&s.attenuation[2]);
+    success &= mci_get_attenuation_ch4(&s.attenuation[3]);
+    success &= mci_get_pulse_pretrigger(&pre);
+    success &= mci_get_pulse_posttrigger(&post);
+    if (!success)
+    {
+        printf("MCI value error : calibration refresh\n");
+        return false;
+    }
+    s.samples = pre + post;
+    if (memcmp(&s, &cached, sizeof(calibration_settings)) != 0)
+    {
+        pthread_mutex_lock(&calibration_lock);
+        cached = s;
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+            attenuation_gain[ch] = powf(10.0f, (float)s.attenuation[ch] / 20.0f);
+        pthread_mutex_unlock(&calibration_lock);
+        printf("OpcUaServer : calibration updated\n");
+    }
+    return true;
+}
+
+void calibration_invalidate()
+{
+    calibration_stale = true;
+}
+
+void calibration_update()
+{
+    seconds_since_check++;
+    if (calibration_stale || (seconds_since_check >= CALIBRATION_RECHECK))
+    {
+        // keep the stale flag if the refresh failed, it will be retried next second
+        calibration_stale = false;
+        if (!calibration_refresh())
+            calibration_stale = true;
+        seconds_since_check = 0;
+    }
+}
+
+/***********************************/
+/* batch processing                */
+/***********************************/
+
+// The conversion is a linear function for every one of the 16 values of a block.
+// Offset and gain for every value are computed once per batch,
+// the conversion is then a simple loop the compiler can vectorize.
+void calibration_apply(const pulse_data *blocks, pulse_data_calibrated *result, int count)
+{
+    float offset[PULSE_CHANNELS*PULSE_FIELDS];
+    float gain[PULSE_CHANNELS*PULSE_FIELDS];
+
+    pthread_mutex_lock(&calibration_lock);
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        float g = calibration_scale[ch] * attenuation_gain[ch];
+        float offs = (float)cached.offset[ch];
+        int i = ch*PULSE_FIELDS;
+        offset[i+FIELD_RSS] = 0.0f;
+        offset[i+FIELD_PEAK] = offs;
+        offset[i+FIELD_AVG] = offs;
+        offset[i+FIELD_SUM] = offs * (float)cached.samples;
+        gain[i+FIELD_RSS] = g;
+        gain[i+FIELD_PEAK] = g;
+        gain[i+FIELD_AVG] = g;
+        gain[i+FIELD_SUM] = g;
+    }
+    pthread_mutex_unlock(&calibration_lock);
+
+    const int32_t *raw = (const int32_t *)blocks;
+    float *out = (float *)result;
+    for (int k=0; k<count; k++)
+    {
+        for (int j=0; j<PULSE_CHANNELS*PULSE_FIELDS; j++)
+            out[j] = ((float)raw[j] - offset[j]) * gain[j];
+        raw += PULSE_CHANNELS*PULSE_FIELDS;
+        out += PULSE_CHANNELS*PULSE_FIELDS;
+    }
+}
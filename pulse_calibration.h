@@ -0,0 +1,100 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_calibration.h
+  OpcUaServer : calibrated pulse data
+  Version 0.2 2026/10/19
+
+  The raw pulse data are converted into physical units using
+  the ADC offsets and attenuator settings of the instrument.
+    peak, avg : (raw - offset) * scale * 10^(att/20)
+    sum       : (raw - offset * samples) * scale * 10^(att/20)
+    rss       : raw * scale * 10^(att/20)
+  The number of samples of the pulse window is pretrigger+posttrigger.
+  The scale (input units per ADC count) is configured per channel.
+
+  The settings are read over MCI and cached. The cache is refreshed
+  when a setting is changed through the OPC UA server and checked
+  at a low rate for changes made by other MCI clients.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PULSECALIBRATION_H
+#define PULSECALIBRATION_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// interval [s] for checking the MCI settings for external changes
+#define CALIBRATION_RECHECK 10
+
+// the calibrated data block - same layout as pulse_data
+typedef struct {
+   float Ch1_rss;
+   float Ch1_peak;
+   float Ch1_avg;
+   float Ch1_sum;
+   float Ch2_rss;
+   float Ch2_peak;
+   float Ch2_avg;
+   float Ch2_sum;
+   float Ch3_rss;
+   float Ch3_peak;
+   float Ch3_avg;
+   float Ch3_sum;
+   float Ch4_rss;
+   float Ch4_peak;
+   float Ch4_avg;
+   float Ch4_sum;
+} pulse_data_calibrated;
+
+// input units per ADC count - writable through the OPC UA server
+extern float calibration_scale[PULSE_CHANNELS];
+
+// read all settings from MCI and rebuild the cached constants
+// returns false if any of the MCI reads failed (the previous values are kept)
+bool calibration_refresh();
+
+// mark the cached constants as outdated
+// they will be refreshed on the next call of calibration_update()
+void calibration_invalidate();
+
+// to be called once every second from the timer thread
+// refreshes the cache if it was invalidated or the re-check interval has expired
+void calibration_update();
+
+// convert a batch of data blocks into physical units
+// the result array must have room for count blocks
+void calibration_apply(const pulse_data *blocks, pulse_data_calibrated *result, int count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
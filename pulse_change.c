@@ -0,0 +1,421 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_change.c
+  OpcUaServer : change-point detection
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "pulse_change.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t change_method = CHANGE_METHOD_CUSUM;
+int32_t change_fields = (1 << FIELD_AVG) | (1 << FIELD_SUM);
+int32_t change_warmup = 1000;
+float change_drift = 0.5f;
+float change_threshold = 10.0f;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+int32_t change_count = 0;
+int32_t change_dropped = 0;
+
+int change_log_columns[CHANGE_LOG_COLUMNS] = {
+    CHANGE_LOG_TIME, CHANGE_LOG_CHANNEL, CHANGE_LOG_FIELD, CHANGE_LOG_BEFORE, CHANGE_LOG_AFTER };
+
+/***********************************/
+/* detectors                       */
+/***********************************/
+
+// One side of a detector watches for an increase (sign +1) or a decrease (sign -1).
+// stat is the CUSUM statistic or the Page-Hinkley sum, low the minimum of the
+// Page-Hinkley sum. sum and n collect z since the statistic started to grow.
+typedef struct {
+    double stat;
+    double low;
+    double sum;
+    int32_t n;
+} detector_side;
+
+typedef struct {
+    int32_t method;             // the method the state was built with
+    // learning the reference
+    int32_t n;
+    double mean;
+    double m2;
+    bool ready;
+    float ref_mean;
+    float ref_sigma;
+    detector_side up;
+    detector_side down;
+} detector;
+
+static detector detectors[PULSE_CHANNELS * PULSE_FIELDS];
+
+static void detector_reset(detector *d, int32_t method)
+{
+    memset(d, 0, sizeof(detector));
+    d->method = method;
+}
+
+// Feed one standardized value to a side. Returns true if a change is detected.
+static bool side_update(detector_side *s, double z, double sign, double k, double h, int32_t method)
+{
+    double dz = sign * z - k;
+    if (method == CHANGE_METHOD_PAGE_HINKLEY)
+    {
+        s->stat += dz;
+        if (s->stat < s->low)
+        {
+            s->low = s->stat;
+            s->sum = 0.0;
+            s->n = 0;
+        }
+        else
+        {
+            s->sum += z;
+            s->n++;
+        }
+        return (s->stat - s->low > h);
+    }
+    s->stat += dz;
+    if (s->stat <= 0.0)
+    {
+        s->stat = 0.0;
+        s->sum = 0.0;
+        s->n = 0;
+    }
+    else
+    {
+        s->sum += z;
+        s->n++;
+    }
+    return (s->stat > h);
+}
+
+/***********************************/
+/* event queue and change log      */
+/***********************************/
+
+#define CHANGE_QUEUE 64
+
+typedef struct {
+    uint64_t sequence;
+    int64_t timestamp;
+    uint64_t trigger;
+    int32_t channel;            // 0..3
+    int32_t field;
+    float before;
+    float after;
+} change_event;
+
+// written by the stream reader thread, read by the server thread
+static change_event queue[CHANGE_QUEUE];
+static int queue_head = 0;
+static int queue_fill = 0;
+static change_event change_log[CHANGE_LOG];
+static int log_next = 0;
+static int log_fill = 0;
+static pthread_mutex_t change_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void report_change(const change_event *ev)
+{
+    pthread_mutex_lock(&change_lock);
+    if (queue_fill == CHANGE_QUEUE)
+        change_dropped++;
+    else
+    {
+        queue[queue_head] = *ev;
+        queue_head = (queue_head + 1) % CHANGE_QUEUE;
+        queue_fill++;
+    }
+    change_log[log_next] = *ev;
+    log_next = (log_next + 1) % CHANGE_LOG;
+    if (log_fill < CHANGE_LOG) log_fill++;
+    pthread_mutex_unlock(&change_lock);
+    change_count++;
+}
+
+/***********************************/
+/* batch processing                */
+/***********************************/
+
+void change_process(const pulse_data *blocks, const pulse_info *info, int count)
+{
+    // take a copy of the configuration, it may be modified by the server at any time
+    int32_t method = change_method;
+    int32_t fields = change_fields;
+    int32_t warmup = (change_warmup > 1) ? change_warmup : 2;
+    double k = change_drift;
+    double h = change_threshold;
+
+    for (int i=0; i<PULSE_CHANNELS*PULSE_FIELDS; i++)
+    {
+        int ch = i / PULSE_FIELDS;
+        int field = i % PULSE_FIELDS;
+        if (!(fields & (1 << field))) continue;
+        detector *d = &detectors[i];
+        if (d->method != method) detector_reset(d, method);
+        for (int j=0; j<count; j++)
+        {
+            // the values are not reliable while the attenuation is changed
+            if (info[j].flags & PULSE_FLAG_RANGING) continue;
+            double x = (double)PULSE_VALUE(&blocks[j], ch, field);
+            if (!d->ready)
+            {
+                // learn the reference (Welford)
+                d->n++;
+                double delta = x - d->mean;
+                d->mean += delta / d->n;
+                d->m2 += delta * (x - d->mean);
+                if (d->n >= warmup)
+                {
+                    d->ref_mean = (float)d->mean;
+                    d->ref_sigma = (float)sqrt(d->m2 / (d->n - 1));
+                    // a constant signal would make every deviation a change
+                    if (d->ref_sigma < 1.0f) d->ref_sigma = 1.0f;
+                    d->ready = true;
+                }
+                continue;
+            }
+            double z = (x - d->ref_mean) / d->ref_sigma;
+            bool up = side_update(&d->up, z, 1.0, k, h, method);
+            bool down = side_update(&d->down, z, -1.0, k, h, method);
+            if (up || down)
+            {
+                const detector_side *s = up ? &d->up : &d->down;
+                double zmean = (s->n > 0) ? s->sum / s->n : (up ? h : -h);
+                change_event ev = {
+                    .sequence = info[j].sequence,
+                    .timestamp = info[j].timestamp,
+                    .trigger = info[j].trigger,
+                    .channel = ch,
+                    .field = field,
+                    .before = d->ref_mean,
+                    .after = (float)(d->ref_mean + zmean * d->ref_sigma) };
+                report_change(&ev);
+                detector_reset(d, method);
+            }
+        }
+    }
+}
+
+/***********************************/
+/* OPC-UA events                   */
+/***********************************/
+
+#define CHANGE_EVENT_TYPE UA_NODEID_STRING(1, "PulseChangeEventType")
+
+static const char *field_names[PULSE_FIELDS] = { "rss", "peak", "avg", "sum" };
+
+static UA_StatusCode add_event_property(UA_Server *server, char *name, char *description, const UA_DataType *type)
+{
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", name);
+    attr.description = UA_LOCALIZEDTEXT("en_US", description);
+    attr.dataType = type->typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    UA_NodeId propertyId;
+    UA_StatusCode retval = UA_Server_addVariableNode(
+            server,
+            UA_NODEID_NULL,
+            CHANGE_EVENT_TYPE,
+            UA_NS0ID(HASPROPERTY),
+            UA_QUALIFIEDNAME(1, name),
+            UA_NS0ID(PROPERTYTYPE),
+            attr,
+            NULL,
+            &propertyId);
+    if (retval != UA_STATUSCODE_GOOD) return retval;
+    // the property has to be instantiated with every event
+    retval = UA_Server_addReference(
+            server,
+            propertyId,
+            UA_NS0ID(HASMODELLINGRULE),
+            UA_NS0EXID(MODELLINGRULE_MANDATORY),
+            true);
+    UA_NodeId_clear(&propertyId);
+    return retval;
+}
+
+static void trigger_event(UA_Server *server, const change_event *ev)
+{
+    UA_NodeId eventId;
+    if (UA_Server_createEvent(server, CHANGE_EVENT_TYPE, &eventId) != UA_STATUSCODE_GOOD)
+    {
+        printf("OpcUaServer : failed to create change event\n");
+        return;
+    }
+    UA_DateTime time = ev->timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Time"),
+                                         &time, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_UInt16 severity = 600;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Severity"),
+                                         &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    char text[128];
+    snprintf(text, sizeof(text), "Ch%d %s changed from %.1f to %.1f",
+             ev->channel + 1, field_names[ev->field], ev->before, ev->after);
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en_US", text);
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Message"),
+                                         &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_String source = UA_STRING("Pulse_acquisition");
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "SourceName"),
+                                         &source, &UA_TYPES[UA_TYPES_STRING]);
+    UA_UInt32 channel = ev->channel + 1;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Channel"),
+                                         &channel, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_UInt32 field = ev->field;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Field"),
+                                         &field, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_Float before = ev->before;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Before"),
+                                         &before, &UA_TYPES[UA_TYPES_FLOAT]);
+    UA_Float after = ev->after;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "After"),
+                                         &after, &UA_TYPES[UA_TYPES_FLOAT]);
+    UA_UInt64 sequence = ev->sequence;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Sequence"),
+                                         &sequence, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_UInt64 trigger = ev->trigger;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Trigger"),
+                                         &trigger, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Server_triggerEvent(server, eventId, UA_NS0ID(SERVER), NULL, true);
+}
+
+// called by the server thread every CHANGE_INTERVAL ms
+#define CHANGE_INTERVAL 50
+
+static void change_callback(UA_Server *server, void *data)
+{
+    change_event pending[CHANGE_QUEUE];
+    pthread_mutex_lock(&change_lock);
+    int n = queue_fill;
+    int start = (queue_head - queue_fill + CHANGE_QUEUE) % CHANGE_QUEUE;
+    for (int i=0; i<n; i++)
+        pending[i] = queue[(start + i) % CHANGE_QUEUE];
+    queue_fill = 0;
+    pthread_mutex_unlock(&change_lock);
+    for (int i=0; i<n; i++)
+        trigger_event(server, &pending[i]);
+}
+
+UA_StatusCode change_add_events(UA_Server *server)
+{
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", "PulseChangeEventType");
+    attr.description = UA_LOCALIZEDTEXT("en_US", "a step of the mean value of a pulse field");
+    UA_StatusCode retval = UA_Server_addObjectTypeNode(
+            server,
+            CHANGE_EVENT_TYPE,
+            UA_NS0ID(BASEEVENTTYPE),
+            UA_NS0ID(HASSUBTYPE),
+            UA_QUALIFIEDNAME(1, "PulseChangeEventType"),
+            attr,
+            NULL,
+            NULL);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Channel", "channel 1..4", &UA_TYPES[UA_TYPES_UINT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Field", "field 0=rss 1=peak 2=avg 3=sum", &UA_TYPES[UA_TYPES_UINT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Before", "mean value before the change", &UA_TYPES[UA_TYPES_FLOAT]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "After", "estimated mean value after the change", &UA_TYPES[UA_TYPES_FLOAT]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Sequence", "sequence number of the detecting block", &UA_TYPES[UA_TYPES_UINT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Trigger", "index of the associated t2 trigger, 0=none", &UA_TYPES[UA_TYPES_UINT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = UA_Server_addRepeatedCallback(server, change_callback, NULL, CHANGE_INTERVAL, NULL);
+    if (retval != UA_STATUSCODE_GOOD)
+        printf("OpcUaServer : failed to add the change events %8x\n", retval);
+    return retval;
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_change_log(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    if (nodeContext == NULL)
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    int column = *(int *)nodeContext;
+    const UA_DataType *type = (column == CHANGE_LOG_TIME) ? &UA_TYPES[UA_TYPES_DATETIME] :
+                              ((column == CHANGE_LOG_BEFORE) || (column == CHANGE_LOG_AFTER)) ? &UA_TYPES[UA_TYPES_FLOAT] :
+                              &UA_TYPES[UA_TYPES_UINT32];
+    pthread_mutex_lock(&change_lock);
+    size_t n = log_fill;
+    void *data = UA_Array_new(n, type);
+    if ((n > 0) && (data == NULL))
+    {
+        pthread_mutex_unlock(&change_lock);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    size_t start = (log_fill == CHANGE_LOG) ? log_next : 0;
+    for (size_t i=0; i<n; i++)
+    {
+        const change_event *ev = &change_log[(start + i) % CHANGE_LOG];
+        switch (column)
+        {
+            case CHANGE_LOG_TIME:
+                ((UA_DateTime *)data)[i] = ev->timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+                break;
+            case CHANGE_LOG_CHANNEL:
+                ((UA_UInt32 *)data)[i] = ev->channel + 1;
+                break;
+            case CHANGE_LOG_FIELD:
+                ((UA_UInt32 *)data)[i] = ev->field;
+                break;
+            case CHANGE_LOG_BEFORE:
+                ((UA_Float *)data)[i] = ev->before;
+                break;
+            default:
+                ((UA_Float *)data)[i] = ev->after;
+                break;
+        }
+    }
+    pthread_mutex_unlock(&change_lock);
+    UA_Variant_setArray(&dataValue->value, data, n, type);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
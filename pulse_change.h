@@ -0,0 +1,116 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_change.h
+  OpcUaServer : change-point detection
+  Version 0.2 2026/10/19
+
+  Every channel and selected field is watched for a step of its mean value.
+  After a reset the reference mean and standard deviation are learned from
+  change_warmup pulses. The following values are standardized with the
+  reference, z = (x - mean) / sigma, and fed to one of two detectors:
+
+  CHANGE_METHOD_CUSUM : two-sided cumulative sum
+    S+ = max(0, S+ + z - k)     S- = max(0, S- - z - k)
+  CHANGE_METHOD_PAGE_HINKLEY :
+    m = sum(z - k), change when m - min(m) exceeds the threshold (and mirrored)
+
+  k is change_drift, a change is detected when the statistic exceeds
+  change_threshold. The mean after the change is estimated from the pulses
+  since the statistic last started to grow. A change raises an event of type
+  PulseChangeEventType with the mean before and after the change and is
+  entered into the change log. The detector then learns a new reference.
+  The cost is constant per pulse and detector.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSECHANGE_H
+#define PULSECHANGE_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define CHANGE_METHOD_CUSUM 0
+#define CHANGE_METHOD_PAGE_HINKLEY 1
+
+// number of entries of the change log
+#define CHANGE_LOG 100
+// columns of the change log
+#define CHANGE_LOG_TIME 0
+#define CHANGE_LOG_CHANNEL 1
+#define CHANGE_LOG_FIELD 2
+#define CHANGE_LOG_BEFORE 3
+#define CHANGE_LOG_AFTER 4
+#define CHANGE_LOG_COLUMNS 5
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t change_method;           // CHANGE_METHOD_*
+extern int32_t change_fields;           // watched fields, bit mask rss=1 peak=2 avg=4 sum=8
+extern int32_t change_warmup;           // pulses to learn the reference
+extern float change_drift;              // allowance k [sigma]
+extern float change_threshold;          // detection threshold h [sigma]
+
+//*************************************
+// results
+//*************************************
+
+extern int32_t change_count;            // changes detected since start
+extern int32_t change_dropped;          // events lost by a full queue
+
+// used as node context of the change log arrays
+extern int change_log_columns[CHANGE_LOG_COLUMNS];
+
+// feed a batch of data blocks to the detectors
+void change_process(const pulse_data *blocks, const pulse_info *info, int count);
+
+// add the event type and start triggering the queued events
+UA_StatusCode change_add_events(UA_Server *server);
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// read one column of the change log, nodeContext points to a CHANGE_LOG_* column index
+UA_StatusCode read_change_log(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,242 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_coincidence.c
+  OpcUaServer : coincidence detection between the channels
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pulse_coincidence.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t coinc_field = FIELD_PEAK;
+int32_t coinc_threshold[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t coinc_window = 0;
+int32_t coinc_pattern[COINC_PATTERNS] = { 0, 0, 0, 0 };
+int32_t coinc_filter = 0;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+int32_t coinc_count[COINC_PATTERNS] = { 0, 0, 0, 0 };
+int32_t coinc_total = 0;
+float coinc_rate[COINC_PATTERNS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+float coinc_singles_rate[PULSE_CHANNELS] = { 0.0f, 0.0f, 0.0f, 0.0f };
+
+// hits not yet consumed by a coincidence, per pattern
+// bit mask of the channels, ingest time and block of the last hit per channel
+static int32_t pending[COINC_PATTERNS];
+static int64_t hit_time[PULSE_CHANNELS];
+static uint64_t hit_sequence[PULSE_CHANNELS];
+
+// The hit counters are only incremented by the stream reader.
+// The timer computes the rates from the differences to the last values.
+static uint32_t singles[PULSE_CHANNELS];
+static uint32_t last_singles[PULSE_CHANNELS];
+static int32_t last_count[COINC_PATTERNS];
+
+/***********************************/
+/* hold queue for the filter       */
+/***********************************/
+
+// With the filter enabled the blocks are held back until their flag is final,
+// i.e. until they are marked coincident or the newest block is beyond the
+// window so they can not contribute to a coincidence any more.
+// Only accessed by the stream reader thread.
+static pulse_data hold_block[COINC_HOLD];
+static pulse_info hold_info[COINC_HOLD];
+static int hold_first = 0;          // index of the oldest entry
+static int hold_fill = 0;
+static int64_t newest_time = 0;     // ingest time of the last processed block
+
+static void hold_append(const pulse_data *block, const pulse_info *info)
+{
+    // cannot happen as long as every batch is followed by coincidence_release()
+    if (hold_fill == COINC_HOLD)
+    {
+        hold_first = (hold_first + 1) % COINC_HOLD;
+        hold_fill--;
+    }
+    int k = (hold_first + hold_fill) % COINC_HOLD;
+    hold_block[k] = *block;
+    hold_info[k] = *info;
+    hold_fill++;
+}
+
+// mark the block with the given sequence number as coincident
+// it is searched in the current batch up to index last and in the hold queue
+static void mark_block(uint64_t sequence, pulse_info *batch, int last)
+{
+    pulse_info *target = NULL;
+    for (int k=last; (k>=0) && (target == NULL); k--)
+    {
+        if (batch[k].sequence < sequence) return;
+        if (batch[k].sequence == sequence) target = &batch[k];
+    }
+    for (int i=hold_fill-1; (i>=0) && (target == NULL); i--)
+    {
+        pulse_info *held = &hold_info[(hold_first + i) % COINC_HOLD];
+        if (held->sequence < sequence) return;
+        if (held->sequence == sequence) target = held;
+    }
+    if ((target != NULL) && !(target->flags & PULSE_FLAG_COINCIDENT))
+    {
+        target->flags |= PULSE_FLAG_COINCIDENT;
+        coinc_total++;
+    }
+}
+
+/***********************************/
+/* batch processing                */
+/***********************************/
+
+#define COINC_BATCH 64
+
+// process the blocks [first, first+n) of the batch
+static void coincidence_process_chunk(const pulse_data *blocks, pulse_info *batch, int first, int n)
+{
+    int32_t hits[COINC_BATCH];
+    blocks += first;
+    pulse_info *info = batch + first;
+
+    // take a copy of the configuration, it may be modified by the server at any time
+    int field = coinc_field;
+    if ((field < 0) || (field >= PULSE_FIELDS)) field = FIELD_PEAK;
+    int64_t window = (int64_t)coinc_window * 1000;
+    int32_t patterns[COINC_PATTERNS];
+    for (int p=0; p<COINC_PATTERNS; p++)
+        patterns[p] = coinc_pattern[p] & 0xF;
+
+    // hit mask of every block
+    for (int k=0; k<n; k++) hits[k] = 0;
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        int32_t thr = coinc_threshold[ch];
+        int32_t bit = 1 << ch;
+        int32_t sum = 0;
+        for (int k=0; k<n; k++)
+        {
+            int32_t hit = (PULSE_VALUE(&blocks[k], ch, field) >= thr) ? bit : 0;
+            hits[k] |= hit;
+            sum += (hit != 0);
+        }
+        singles[ch] += sum;
+    }
+
+    // combine with the hits of the preceding blocks
+    for (int k=0; k<n; k++)
+    {
+        if (hits[k] == 0) continue;
+        int64_t t = info[k].timestamp;
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+            if (hits[k] & (1 << ch))
+            {
+                hit_time[ch] = t;
+                hit_sequence[ch] = info[k].sequence;
+            }
+        for (int p=0; p<COINC_PATTERNS; p++)
+        {
+            int32_t pattern = patterns[p];
+            if ((pattern == 0) || ((hits[k] & pattern) == 0)) continue;
+            // drop the pending hits that have left the window
+            int32_t mask = pending[p] | (hits[k] & pattern);
+            for (int ch=0; ch<PULSE_CHANNELS; ch++)
+                if ((mask & (1 << ch)) && (t - hit_time[ch] > window))
+                    mask &= ~(1 << ch);
+            if (mask == pattern)
+            {
+                // mark all blocks contributing a hit
+                coinc_count[p]++;
+                for (int ch=0; ch<PULSE_CHANNELS; ch++)
+                    if (pattern & (1 << ch))
+                        mark_block(hit_sequence[ch], batch, first + k);
+                mask = 0;
+            }
+            pending[p] = mask;
+        }
+    }
+}
+
+bool coincidence_process(const pulse_data *blocks, pulse_info *info, int count)
+{
+    bool filter = (coinc_filter != 0);
+    // blocks still held when the filter was switched off are discarded
+    if (!filter) hold_fill = 0;
+    for (int first=0; first<count; first+=COINC_BATCH)
+    {
+        int n = (count - first > COINC_BATCH) ? COINC_BATCH : count - first;
+        coincidence_process_chunk(blocks, info, first, n);
+    }
+    if (count > 0) newest_time = info[count-1].timestamp;
+    if (!filter) return false;
+    for (int k=0; k<count; k++)
+        hold_append(&blocks[k], &info[k]);
+    return true;
+}
+
+int coincidence_release(pulse_data *blocks, pulse_info *info, int max)
+{
+    int64_t window = (int64_t)coinc_window * 1000;
+    int n = 0;
+    while ((hold_fill > 0) && (n < max))
+    {
+        const pulse_info *held = &hold_info[hold_first];
+        bool coincident = (held->flags & PULSE_FLAG_COINCIDENT) != 0;
+        // keep the blocks which may still contribute to a coincidence,
+        // unless the window is too long for the hold queue
+        if (!coincident && (newest_time - held->timestamp <= window) && (hold_fill <= COINC_HOLD / 2)) break;
+        if (coincident)
+        {
+            blocks[n] = hold_block[hold_first];
+            info[n] = *held;
+            n++;
+        }
+        hold_first = (hold_first + 1) % COINC_HOLD;
+        hold_fill--;
+    }
+    return n;
+}
+
+void coincidence_update()
+{
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        uint32_t c = singles[ch];
+        coinc_singles_rate[ch] = (float)(c - last_singles[ch]);
+        last_singles[ch] = c;
+    }
+    for (int p=0; p<COINC_PATTERNS; p++)
+    {
+        int32_t c = coinc_count[p];
+        coinc_rate[p] = (float)(c - last_count[p]);
+        last_count[p] = c;
+    }
+}
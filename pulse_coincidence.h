@@ -0,0 +1,100 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_coincidence.h
+  OpcUaServer : coincidence detection between the channels
+  Version 0.2 2026/10/19
+
+  A channel has a hit when its value reaches the channel threshold.
+  A coincidence pattern is a bit mask of channels (Ch1=1 Ch2=2 Ch3=4 Ch4=8)
+  which all must have a hit within the coincidence window.
+  Hits in the same block are always coincident, hits in neighbouring blocks
+  are coincident when their ingest times differ by no more than the window.
+
+  The coincidence is detected at the block that completes the pattern.
+  This block and all blocks contributing a hit are marked with
+  PULSE_FLAG_COINCIDENT. The hits forming a coincidence are consumed,
+  they do not contribute to a further one of the same pattern.
+
+  With the filter enabled only the marked blocks are passed on to the
+  following processing stages. The blocks are held back until their mark
+  is final, that is until the newest block is beyond the coincidence window.
+  The blocks therefore reach the following stages with a delay of (usually)
+  one batch. Without the filter the contributing blocks of preceding batches
+  have already been passed on and are not marked.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PULSECOINCIDENCE_H
+#define PULSECOINCIDENCE_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of configurable patterns
+#define COINC_PATTERNS 4
+// maximum number of blocks held back for the filter
+#define COINC_HOLD 1024
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t coinc_field;                         // compared field FIELD_*
+extern int32_t coinc_threshold[PULSE_CHANNELS];     // hit threshold per channel
+extern int32_t coinc_window;                        // coincidence window [us]
+extern int32_t coinc_pattern[COINC_PATTERNS];       // channel bit masks, 0=unused
+extern int32_t coinc_filter;                        // 1=pass only coincident blocks
+
+//*************************************
+// results
+//*************************************
+
+extern int32_t coinc_count[COINC_PATTERNS];         // coincidences per pattern since start
+extern int32_t coinc_total;                         // blocks marked coincident since start
+extern float coinc_rate[COINC_PATTERNS];            // coincidences per pattern [1/s]
+extern float coinc_singles_rate[PULSE_CHANNELS];    // hits per channel [1/s]
+
+// find the coincidences in a batch of data blocks and mark the blocks
+// With the filter enabled the blocks are moved into the hold queue and true is returned.
+bool coincidence_process(const pulse_data *blocks, pulse_info *info, int count);
+
+// take up to max coincident blocks from the hold queue whose mark is final
+// blocks that are not coincident are discarded, returns the number of blocks
+int coincidence_release(pulse_data *blocks, pulse_info *info, int max);
+
+// to be called once every second from the timer thread
+void coincidence_update();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
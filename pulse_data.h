@@ -0,0 +1,97 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_data.h
+  OpcUaServer : pulse data stream
+  Version 0.2 2026/10/19
+
+  The data block sent by the pulse processing of the instrument.
+  It is shared by the stream reader and all stages processing the pulse data.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEDATA_H
+#define PULSEDATA_H
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the data structure sent by the Libera instrument
+typedef struct {
+   int32_t Ch1_rss;
+   int32_t Ch1_peak;
+   int32_t Ch1_avg;
+   int32_t Ch1_sum;
+   int32_t Ch2_rss;
+   int32_t Ch2_peak;
+   int32_t Ch2_avg;
+   int32_t Ch2_sum;
+   int32_t Ch3_rss;
+   int32_t Ch3_peak;
+   int32_t Ch3_avg;
+   int32_t Ch3_sum;
+   int32_t Ch4_rss;
+   int32_t Ch4_peak;
+   int32_t Ch4_avg;
+   int32_t Ch4_sum;
+} pulse_data;
+#define BLOCKSIZE 64
+
+// The block consists of 4 channels with 4 fields each.
+// The fields can be addressed by index viewing the block as an array.
+#define PULSE_CHANNELS 4
+#define PULSE_FIELDS 4
+#define FIELD_RSS 0
+#define FIELD_PEAK 1
+#define FIELD_AVG 2
+#define FIELD_SUM 3
+#define PULSE_VALUE(block, ch, field) (((const int32_t *)(block))[(ch)*PULSE_FIELDS+(field)])
+
+// Additional information for every block, assigned by the stream reader
+// and passed along with the block through all processing stages.
+typedef struct {
+    uint64_t sequence;      // running number of the block since server start
+    int64_t timestamp;      // ingest time [ns since 1970-01-01 UTC]
+    uint32_t flags;         // PULSE_FLAG_*
+    uint64_t trigger;       // index (t2_count) of the associated t2 trigger
+    int64_t trigger_offset; // time since the associated trigger [ns]
+} pulse_info;
+
+// The flags are set by the processing stages to mark pulses for the following stages.
+#define PULSE_FLAG_CLIPPED_CH1 0x0001       // peak at the ADC limit
+#define PULSE_FLAG_CLIPPED_CH2 0x0002
+#define PULSE_FLAG_CLIPPED_CH3 0x0004
+#define PULSE_FLAG_CLIPPED_CH4 0x0008
+#define PULSE_FLAG_RANGING 0x0010           // attenuation change in progress
+#define PULSE_FLAG_OUTLIER 0x0020           // deviates from the median by more than the limit
+#define PULSE_FLAG_COINCIDENT 0x0040        // contributes to a coincidence of the channels
+#define PULSE_FLAG_TRIGGER 0x0080           // associated with a t2 trigger
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,227 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_event.c
+  OpcUaServer : one OPC UA event per pulse
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pulse_event.h"
+
+int32_t event_mode = EVENT_MODE_OFF;
+uint32_t event_count = 0;
+uint32_t event_dropped = 0;
+int32_t event_items = 0;
+
+/***********************************/
+/* event queue                     */
+/***********************************/
+
+typedef struct {
+    pulse_data block;
+    pulse_info info;
+} pulse_event;
+
+// written by the stream reader thread, read by the server thread
+static pulse_event queue[EVENT_QUEUE];
+static int queue_head = 0;      // next entry to be written
+static int queue_fill = 0;
+static pthread_mutex_t event_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void event_process(const pulse_data *blocks, const pulse_info *info, int count, bool accepted)
+{
+    int mode = event_mode;
+    if (mode == EVENT_MODE_OFF) return;
+    if ((mode == EVENT_MODE_ACCEPTED) != accepted) return;
+    // nobody would receive the events
+    if (event_items == 0) return;
+    pthread_mutex_lock(&event_lock);
+    for (int k=0; k<count; k++)
+    {
+        if (queue_fill == EVENT_QUEUE)
+        {
+            event_dropped++;
+            continue;
+        }
+        queue[queue_head].block = blocks[k];
+        queue[queue_head].info = info[k];
+        queue_head = (queue_head + 1) % EVENT_QUEUE;
+        queue_fill++;
+    }
+    pthread_mutex_unlock(&event_lock);
+}
+
+/***********************************/
+/* OPC-UA events                   */
+/***********************************/
+
+#define PULSE_EVENT_TYPE UA_NODEID_STRING(1, "PulseEventType")
+
+static char *value_names[PULSE_CHANNELS*PULSE_FIELDS] = {
+    "Ch1_rss", "Ch1_peak", "Ch1_avg", "Ch1_sum",
+    "Ch2_rss", "Ch2_peak", "Ch2_avg", "Ch2_sum",
+    "Ch3_rss", "Ch3_peak", "Ch3_avg", "Ch3_sum",
+    "Ch4_rss", "Ch4_peak", "Ch4_avg", "Ch4_sum" };
+
+static UA_StatusCode add_event_property(UA_Server *server, char *name, char *description, const UA_DataType *type)
+{
+    UA_VariableAttributes attr = UA_VariableAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", name);
+    attr.description = UA_LOCALIZEDTEXT("en_US", description);
+    attr.dataType = type->typeId;
+    attr.valueRank = UA_VALUERANK_SCALAR;
+    UA_NodeId propertyId;
+    UA_StatusCode retval = UA_Server_addVariableNode(
+            server,
+            UA_NODEID_NULL,
+            PULSE_EVENT_TYPE,
+            UA_NS0ID(HASPROPERTY),
+            UA_QUALIFIEDNAME(1, name),
+            UA_NS0ID(PROPERTYTYPE),
+            attr,
+            NULL,
+            &propertyId);
+    if (retval != UA_STATUSCODE_GOOD) return retval;
+    // the property has to be instantiated with every event
+    retval = UA_Server_addReference(
+            server,
+            propertyId,
+            UA_NS0ID(HASMODELLINGRULE),
+            UA_NS0EXID(MODELLINGRULE_MANDATORY),
+            true);
+    UA_NodeId_clear(&propertyId);
+    return retval;
+}
+
+static void trigger_event(UA_Server *server, const pulse_event *ev)
+{
+    UA_NodeId eventId;
+    if (UA_Server_createEvent(server, PULSE_EVENT_TYPE, &eventId) != UA_STATUSCODE_GOOD)
+    {
+        printf("OpcUaServer : failed to create pulse event\n");
+        return;
+    }
+    UA_DateTime time = ev->info.timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Time"),
+                                         &time, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_UInt16 severity = 100;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Severity"),
+                                         &severity, &UA_TYPES[UA_TYPES_UINT16]);
+    UA_LocalizedText message = UA_LOCALIZEDTEXT("en_US", "pulse");
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "Message"),
+                                         &message, &UA_TYPES[UA_TYPES_LOCALIZEDTEXT]);
+    UA_String source = UA_STRING("Pulse_acquisition");
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(0, "SourceName"),
+                                         &source, &UA_TYPES[UA_TYPES_STRING]);
+    for (int i=0; i<PULSE_CHANNELS*PULSE_FIELDS; i++)
+    {
+        UA_Int32 value = ((const int32_t *)&ev->block)[i];
+        UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, value_names[i]),
+                                             &value, &UA_TYPES[UA_TYPES_INT32]);
+    }
+    UA_UInt64 sequence = ev->info.sequence;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Sequence"),
+                                         &sequence, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_UInt32 flags = ev->info.flags;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Flags"),
+                                         &flags, &UA_TYPES[UA_TYPES_UINT32]);
+    UA_UInt64 trigger = ev->info.trigger;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "Trigger"),
+                                         &trigger, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Int64 offset = ev->info.trigger_offset;
+    UA_Server_writeObjectProperty_scalar(server, eventId, UA_QUALIFIEDNAME(1, "TriggerOffset"),
+                                         &offset, &UA_TYPES[UA_TYPES_INT64]);
+    // the where-clauses of the event filters are evaluated here,
+    // the event is only queued for the monitored items it passes
+    UA_Server_triggerEvent(server, eventId, UA_NS0ID(SERVER), NULL, true);
+    event_count++;
+}
+
+// called by the server thread every EVENT_INTERVAL ms
+// at most EVENT_BATCH events are triggered, the remaining pulses stay queued
+static void event_callback(UA_Server *server, void *data)
+{
+    static pulse_event pending[EVENT_BATCH];
+    pthread_mutex_lock(&event_lock);
+    // discard the pulses queued before the last event subscription was removed
+    if (event_items == 0) queue_fill = 0;
+    int n = (queue_fill > EVENT_BATCH) ? EVENT_BATCH : queue_fill;
+    int start = (queue_head - queue_fill + EVENT_QUEUE) % EVENT_QUEUE;
+    for (int i=0; i<n; i++)
+        pending[i] = queue[(start + i) % EVENT_QUEUE];
+    queue_fill -= n;
+    pthread_mutex_unlock(&event_lock);
+    for (int i=0; i<n; i++)
+        trigger_event(server, &pending[i]);
+}
+
+// called by the server thread whenever a monitored item is created or deleted
+void event_monitored_item(UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_UInt32 attributeId, UA_Boolean removed)
+{
+    if (attributeId != UA_ATTRIBUTEID_EVENTNOTIFIER) return;
+    if (removed)
+    {
+        if (event_items > 0) event_items--;
+    }
+    else
+        event_items++;
+}
+
+UA_StatusCode event_add_events(UA_Server *server)
+{
+    UA_ObjectTypeAttributes attr = UA_ObjectTypeAttributes_default;
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", "PulseEventType");
+    attr.description = UA_LOCALIZEDTEXT("en_US", "the complete data of one pulse");
+    UA_StatusCode retval = UA_Server_addObjectTypeNode(
+            server,
+            PULSE_EVENT_TYPE,
+            UA_NS0ID(BASEEVENTTYPE),
+            UA_NS0ID(HASSUBTYPE),
+            UA_QUALIFIEDNAME(1, "PulseEventType"),
+            attr,
+            NULL,
+            NULL);
+    for (int i=0; (i<PULSE_CHANNELS*PULSE_FIELDS) && (retval == UA_STATUSCODE_GOOD); i++)
+        retval = add_event_property(server, value_names[i], value_names[i], &UA_TYPES[UA_TYPES_INT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Sequence", "sequence number of the block", &UA_TYPES[UA_TYPES_UINT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Flags", "flags of the block PULSE_FLAG_*", &UA_TYPES[UA_TYPES_UINT32]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "Trigger", "index of the associated t2 trigger, 0=none", &UA_TYPES[UA_TYPES_UINT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = add_event_property(server, "TriggerOffset", "time since the associated t2 trigger [ns]", &UA_TYPES[UA_TYPES_INT64]);
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = UA_Server_addRepeatedCallback(server, event_callback, NULL, EVENT_INTERVAL, NULL);
+    if (retval != UA_STATUSCODE_GOOD)
+        printf("OpcUaServer : failed to add the pulse events %8x\n", retval);
+    return retval;
+}
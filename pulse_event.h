@@ -0,0 +1,106 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_event.h
+  OpcUaServer : one OPC UA event per pulse
+  Version 0.2 2026/10/19
+
+  Optionally an event of type PulseEventType is emitted for every pulse.
+  Its fields are the 16 values of the data block (Ch1_rss ... Ch4_sum),
+  the sequence number, the flags and the associated t2 trigger with the
+  time offset from it. The event time is the ingest time of the block.
+
+  The events are filtered by the server with the where-clause of the
+  event filter of every monitored item before they are queued,
+  a client subscribing with e.g. Ch1_peak > 1000 only receives those pulses.
+
+  With EVENT_MODE_ALL every ingested pulse raises an event,
+  with EVENT_MODE_ACCEPTED only the pulses passing the outlier rejection
+  and the coincidence filter.
+
+  The stream reader thread only queues the pulses.
+  The events are triggered by a callback of the server thread, at most
+  EVENT_BATCH per call. The pulses are only queued and the events only
+  created while a client monitors events (a monitored item on the
+  EventNotifier attribute of any node), otherwise the work is skipped.
+  The monitored items are counted by event_monitored_item(), which has
+  to be set as monitoredItemRegisterCallback of the server configuration.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEEVENT_H
+#define PULSEEVENT_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define EVENT_MODE_OFF 0
+#define EVENT_MODE_ALL 1
+#define EVENT_MODE_ACCEPTED 2
+
+// number of pulses that can wait for the server thread
+#define EVENT_QUEUE 1024
+// interval of the server callback triggering the events [ms]
+#define EVENT_INTERVAL 20
+// maximum number of events triggered per callback
+#define EVENT_BATCH 256
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t event_mode;          // EVENT_MODE_*
+
+//*************************************
+// results
+//*************************************
+
+extern uint32_t event_count;        // number of events triggered
+extern uint32_t event_dropped;      // pulses lost by a full queue
+extern int32_t event_items;         // number of monitored items on events
+
+// queue a batch of data blocks
+// accepted is false before and true after the rejection of blocks by the processing stages
+void event_process(const pulse_data *blocks, const pulse_info *info, int count, bool accepted);
+
+// add the event type and start triggering the queued events
+UA_StatusCode event_add_events(UA_Server *server);
+
+// count the monitored items on events - monitoredItemRegisterCallback of the server
+void event_monitored_item(UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_UInt32 attributeId, UA_Boolean removed);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,362 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_expression.c
+  OpcUaServer : derived quantities from expressions
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <ctype.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "pulse_expression.h"
+
+/***********************************/
+/* compiled expressions            */
+/***********************************/
+
+typedef enum {
+    OP_FIELD, OP_CONST,
+    OP_ADD, OP_SUB, OP_MUL, OP_DIV, OP_NEG,
+    OP_ABS, OP_SQRT, OP_MIN, OP_MAX
+} op_code;
+
+typedef struct {
+    op_code op;
+    int field;                      // index into the block for OP_FIELD
+    float constant;                 // value for OP_CONST
+} instruction;
+
+typedef struct {
+    const char *name;
+    int n;
+    instruction code[EXPRESSION_CODE];
+    float value;                    // result for the last block
+} expression;
+
+static expression expressions[EXPRESSION_MAX];
+static int expression_count = 0;
+
+// expressions are compiled by the main thread while the stream may already be running
+static pthread_mutex_t expression_lock = PTHREAD_MUTEX_INITIALIZER;
+
+/***********************************/
+/* compiler                        */
+/***********************************/
+
+// Recursive descent parser emitting the instructions in postfix order.
+//   expr    := term { (+|-) term }
+//   term    := factor { (*|/) factor }
+//   factor  := - factor | primary
+//   primary := number | field | function ( expr [, expr] ) | ( expr )
+
+typedef struct {
+    const char *p;                  // current position in the text
+    expression *e;
+    int depth;                      // stack depth at the current position
+    int max_depth;
+    const char *error;
+} parser;
+
+static const char *field_names[PULSE_CHANNELS*PULSE_FIELDS] = {
+    "Ch1_rss", "Ch1_peak", "Ch1_avg", "Ch1_sum",
+    "Ch2_rss", "Ch2_peak", "Ch2_avg", "Ch2_sum",
+    "Ch3_rss", "Ch3_peak", "Ch3_avg", "Ch3_sum",
+    "Ch4_rss", "Ch4_peak", "Ch4_avg", "Ch4_sum" };
+
+static void skip_space(parser *ps)
+{
+    while (isspace((unsigned char)*ps->p)) ps->p++;
+}
+
+static bool emit(parser *ps, op_code op, int field, float constant)
+{
+    if (ps->e->n >= EXPRESSION_CODE)
+    {
+        ps->error = "expression too long";
+        return false;
+    }
+    instruction *i = &ps->e->code[ps->e->n++];
+    i->op = op;
+    i->field = field;
+    i->constant = constant;
+    // operands push one value, binary operators pop one, unary ones leave the depth
+    if ((op == OP_FIELD) || (op == OP_CONST))
+        ps->depth++;
+    else if ((op == OP_ADD) || (op == OP_SUB) || (op == OP_MUL) || (op == OP_DIV) || (op == OP_MIN) || (op == OP_MAX))
+        ps->depth--;
+    if (ps->depth > ps->max_depth) ps->max_depth = ps->depth;
+    return true;
+}
+
+static bool parse_expr(parser *ps);
+
+static bool parse_primary(parser *ps)
+{
+    skip_space(ps);
+    const char *start = ps->p;
+    if (isdigit((unsigned char)*ps->p) || (*ps->p == '.'))
+    {
+        char *end;
+        float v = strtof(ps->p, &end);
+        ps->p = end;
+        return emit(ps, OP_CONST, 0, v);
+    }
+    if (isalpha((unsigned char)*ps->p) || (*ps->p == '_'))
+    {
+        while (isalnum((unsigned char)*ps->p) || (*ps->p == '_')) ps->p++;
+        size_t len = ps->p - start;
+        for (int f=0; f<PULSE_CHANNELS*PULSE_FIELDS; f++)
+            if ((strlen(field_names[f]) == len) && (strncmp(start, field_names[f], len) == 0))
+                return emit(ps, OP_FIELD, f, 0.0f);
+        op_code op;
+        int args;
+        if ((len == 3) && (strncmp(start, "abs", 3) == 0)) { op = OP_ABS; args = 1; }
+        else if ((len == 4) && (strncmp(start, "sqrt", 4) == 0)) { op = OP_SQRT; args = 1; }
+        else if ((len == 3) && (strncmp(start, "min", 3) == 0)) { op = OP_MIN; args = 2; }
+        else if ((len == 3) && (strncmp(start, "max", 3) == 0)) { op = OP_MAX; args = 2; }
+        else
+        {
+            ps->error = "unknown name";
+            return false;
+        }
+        skip_space(ps);
+        if (*ps->p != '(')
+        {
+            ps->error = "missing ( after function name";
+            return false;
+        }
+        ps->p++;
+        if (!parse_expr(ps)) return false;
+        if (args == 2)
+        {
+            skip_space(ps);
+            if (*ps->p != ',')
+            {
+                ps->error = "missing second argument";
+                return false;
+            }
+            ps->p++;
+            if (!parse_expr(ps)) return false;
+        }
+        skip_space(ps);
+        if (*ps->p != ')')
+        {
+            ps->error = "missing )";
+            return false;
+        }
+        ps->p++;
+        return emit(ps, op, 0, 0.0f);
+    }
+    if (*ps->p == '(')
+    {
+        ps->p++;
+        if (!parse_expr(ps)) return false;
+        skip_space(ps);
+        if (*ps->p != ')')
+        {
+            ps->error = "missing )";
+            return false;
+        }
+        ps->p++;
+        return true;
+    }
+    ps->error = "operand expected";
+    return false;
+}
+
+static bool parse_factor(parser *ps)
+{
+    skip_space(ps);
+    if (*ps->p == '-')
+    {
+        ps->p++;
+        if (!parse_factor(ps)) return false;
+        return emit(ps, OP_NEG, 0, 0.0f);
+    }
+    return parse_primary(ps);
+}
+
+static bool parse_term(parser *ps)
+{
+    if (!parse_factor(ps)) return false;
+    while (true)
+    {
+        skip_space(ps);
+        char c = *ps->p;
+        if ((c != '*') && (c != '/')) return true;
+        ps->p++;
+        if (!parse_factor(ps)) return false;
+        if (!emit(ps, (c == '*') ? OP_MUL : OP_DIV, 0, 0.0f)) return false;
+    }
+}
+
+static bool parse_expr(parser *ps)
+{
+    if (!parse_term(ps)) return false;
+    while (true)
+    {
+        skip_space(ps);
+        char c = *ps->p;
+        if ((c != '+') && (c != '-')) return true;
+        ps->p++;
+        if (!parse_term(ps)) return false;
+        if (!emit(ps, (c == '+') ? OP_ADD : OP_SUB, 0, 0.0f)) return false;
+    }
+}
+
+void* expression_compile(const char *name, const char *text)
+{
+    pthread_mutex_lock(&expression_lock);
+    if (expression_count >= EXPRESSION_MAX)
+    {
+        pthread_mutex_unlock(&expression_lock);
+        printf("OpcUaServer : expression %s : too many expressions\n", name);
+        return NULL;
+    }
+    expression *e = &expressions[expression_count];
+    e->name = name;
+    e->n = 0;
+    e->value = NAN;
+    parser ps = { .p = text, .e = e, .depth = 0, .max_depth = 0, .error = NULL };
+    bool success = parse_expr(&ps);
+    skip_space(&ps);
+    if (success && (*ps.p != 0))
+    {
+        ps.error = "unexpected character";
+        success = false;
+    }
+    if (success && (ps.max_depth > EXPRESSION_STACK))
+    {
+        ps.error = "expression too deeply nested";
+        success = false;
+    }
+    if (!success)
+    {
+        pthread_mutex_unlock(&expression_lock);
+        printf("OpcUaServer : expression %s : %s at position %d\n", name, ps.error, (int)(ps.p - text));
+        return NULL;
+    }
+    expression_count++;
+    pthread_mutex_unlock(&expression_lock);
+    printf("OpcUaServer : expression %s compiled to %d instructions\n", name, e->n);
+    return e;
+}
+
+/***********************************/
+/* evaluation                      */
+/***********************************/
+
+#define TOP stack[sp-1]
+#define NEXT stack[sp-2]
+
+static void evaluate(expression *e, const pulse_data *block)
+{
+    float stack[EXPRESSION_STACK];
+    int sp = 0;
+    for (int i=0; i<e->n; i++)
+    {
+        const instruction *in = &e->code[i];
+        // the operands are addressed only by the instructions using them,
+        // the compiler guarantees the stack depth for every instruction
+        switch (in->op)
+        {
+            case OP_FIELD:
+                stack[sp++] = (float)((const int32_t *)block)[in->field];
+                break;
+            case OP_CONST:
+                stack[sp++] = in->constant;
+                break;
+            case OP_ADD:
+                NEXT = NEXT + TOP;
+                sp--;
+                break;
+            case OP_SUB:
+                NEXT = NEXT - TOP;
+                sp--;
+                break;
+            case OP_MUL:
+                NEXT = NEXT * TOP;
+                sp--;
+                break;
+            case OP_DIV:
+                NEXT = NEXT / TOP;
+                sp--;
+                break;
+            case OP_MIN:
+                NEXT = (TOP < NEXT) ? TOP : NEXT;
+                sp--;
+                break;
+            case OP_MAX:
+                NEXT = (TOP > NEXT) ? TOP : NEXT;
+                sp--;
+                break;
+            case OP_NEG:
+                TOP = -TOP;
+                break;
+            case OP_ABS:
+                TOP = fabsf(TOP);
+                break;
+            case OP_SQRT:
+                TOP = sqrtf(TOP);
+                break;
+        }
+    }
+    e->value = stack[0];
+}
+
+void expression_process(const pulse_data *blocks, int count)
+{
+    if (count <= 0) return;
+    // only the values of the last block are published, so only this block is evaluated
+    pthread_mutex_lock(&expression_lock);
+    for (int i=0; i<expression_count; i++)
+        evaluate(&expressions[i], &blocks[count-1]);
+    pthread_mutex_unlock(&expression_lock);
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_expression(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    if (nodeContext == NULL)
+        return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    UA_Float value = ((expression *)nodeContext)->value;
+    UA_Variant_setScalarCopy(&dataValue->value, &value, &UA_TYPES[UA_TYPES_FLOAT]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
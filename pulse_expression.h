@@ -0,0 +1,86 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_expression.h
+  OpcUaServer : derived quantities from expressions
+  Version 0.2 2026/10/19
+
+  Derived quantities are defined in variables.xml as expressions
+  over the fields of the pulse data, e.g.
+    <expression name="asym_13" expr="(Ch1_sum - Ch3_sum) / (Ch1_sum + Ch3_sum)" .../>
+  The expressions are compiled at startup into a short stack program.
+  Only the value of the last block of every batch is published,
+  so the programs are only run for this block.
+
+  Syntax :
+    operands  : the 16 fields Ch1_rss ... Ch4_sum, numbers
+    operators : + - * / and unary minus, parentheses
+    functions : abs(x) sqrt(x) min(x,y) max(x,y)
+  The evaluation is done in single precision floating point.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEEXPRESSION_H
+#define PULSEEXPRESSION_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// largest number of expressions
+#define EXPRESSION_MAX 32
+// largest number of instructions of one expression
+#define EXPRESSION_CODE 64
+// largest stack depth of one expression
+#define EXPRESSION_STACK 8
+
+// A compiled expression, the result is the value for the last evaluated block.
+// Returns NULL if the expression can not be compiled, the reason is printed.
+void* expression_compile(const char *name, const char *text);
+
+// evaluate all expressions for the last block of a batch
+void expression_process(const pulse_data *blocks, int count);
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// read the value of an expression, nodeContext is the compiled expression
+UA_StatusCode read_expression(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
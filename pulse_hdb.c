@@ -0,0 +1,594 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_hdb.c
+  OpcUaServer : history database of the stream variables
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "pulse_hdb.h"
+#include "pulse_archive.h"
+
+/***********************************/
+/* storage                         */
+/***********************************/
+
+// one recorded value, the value is stored with the size of its data type
+typedef struct {
+    UA_DateTime time;
+    union {
+        UA_Int32 i32;
+        UA_UInt32 u32;
+        UA_Float f;
+        UA_Double d;
+        UA_Int64 i64;
+        UA_UInt64 u64;
+    } value;
+} hdb_entry;
+
+// The entries are addressed by their running number since the start.
+// The entry with number j is kept at ring[j % length]
+// as long as j >= written - length.
+// The values of the pulses are taken from the states at offset,
+// the other variables are sampled from var.
+typedef struct {
+    UA_NodeId id;
+    const UA_DataType *type;
+    const void *var;            // NULL for the values of the pulses
+    size_t offset;
+    hdb_entry *ring;
+    uint64_t length;
+    uint64_t written;
+} hdb_node;
+
+// written by the stream reader thread, read by the server thread
+static hdb_node nodes[HDB_NODES];
+static int node_count = 0;
+static pthread_mutex_t hdb_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void hdb_register(UA_NodeId id, const void *var, const UA_DataType *type)
+{
+    if (type->memSize > sizeof(((hdb_entry *)NULL)->value))
+    {
+        printf("OpcUaServer : data type %s can not be historized\n", type->typeName);
+        return;
+    }
+    // the values within the stream snapshot are recorded for every pulse
+    const char *base = (const char *)&stream_snapshot;
+    bool pulse = ((const char *)var >= base) && ((const char *)var + type->memSize <= base + sizeof(pulse_snapshot));
+    uint64_t length = pulse ? HDB_LENGTH : HDB_SAMPLED_LENGTH;
+    hdb_entry *ring = (hdb_entry *) calloc(length, sizeof(hdb_entry));
+    if (ring == NULL)
+    {
+        printf("OpcUaServer : failed to allocate the history of a variable\n");
+        return;
+    }
+    pthread_mutex_lock(&hdb_lock);
+    if (node_count == HDB_NODES)
+    {
+        pthread_mutex_unlock(&hdb_lock);
+        free(ring);
+        printf("OpcUaServer : too many historized variables, increase HDB_NODES\n");
+        return;
+    }
+    hdb_node *node = &nodes[node_count];
+    node->id = id;
+    node->type = type;
+    node->var = pulse ? NULL : var;
+    node->offset = pulse ? (size_t)((const char *)var - base) : 0;
+    node->ring = ring;
+    node->length = length;
+    node->written = 0;
+    node_count++;
+    pthread_mutex_unlock(&hdb_lock);
+}
+
+static hdb_node *find_node(const UA_NodeId *id)
+{
+    for (int k=0; k<node_count; k++)
+        if (UA_NodeId_equal(&nodes[k].id, id)) return &nodes[k];
+    return NULL;
+}
+
+static uint64_t oldest(const hdb_node *node)
+{
+    return (node->written > node->length) ? node->written - node->length : 0;
+}
+
+static UA_DateTime entry_time(const hdb_node *node, uint64_t j)
+{
+    return node->ring[j % node->length].time;
+}
+
+// the first entry with a time >= t (after = false) or > t (after = true)
+// returns written if there is none
+static uint64_t search(const hdb_node *node, UA_DateTime t, bool after)
+{
+    uint64_t lo = oldest(node);
+    uint64_t hi = node->written;
+    while (lo < hi)
+    {
+        uint64_t mid = lo + (hi - lo) / 2;
+        UA_DateTime tm = entry_time(node, mid);
+        if ((tm < t) || (after && (tm == t)))
+            lo = mid + 1;
+        else
+            hi = mid;
+    }
+    return lo;
+}
+
+/***********************************/
+/* recording                       */
+/***********************************/
+
+// append one value, the ring is kept ordered in time if the clock was set back
+static void append(hdb_node *node, UA_DateTime time, const void *value)
+{
+    hdb_entry *entry = &node->ring[node->written % node->length];
+    if ((node->written > 0) && (time < entry_time(node, node->written - 1)))
+        time = entry_time(node, node->written - 1);
+    entry->time = time;
+    memcpy(&entry->value, value, node->type->memSize);
+    node->written++;
+}
+
+void hdb_process(const pulse_snapshot *states, int count)
+{
+    if (count <= 0) return;
+    UA_DateTime last = states[count-1].timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+    pthread_mutex_lock(&hdb_lock);
+    for (int i=0; i<node_count; i++)
+    {
+        hdb_node *node = &nodes[i];
+        if (node->var == NULL)
+        {
+            for (int k=0; k<count; k++)
+                append(node, states[k].timestamp / 100 + UA_DATETIME_UNIX_EPOCH,
+                       (const char *)&states[k] + node->offset);
+        }
+        else
+        {
+            // only the changes of the sampled variables are recorded
+            const hdb_entry *previous = &node->ring[(node->written + node->length - 1) % node->length];
+            if ((node->written == 0) || (memcmp(&previous->value, node->var, node->type->memSize) != 0))
+                append(node, last, node->var);
+        }
+    }
+    pthread_mutex_unlock(&hdb_lock);
+}
+
+/***********************************/
+/* database plugin                 */
+/***********************************/
+
+static void hdb_clear(UA_HistoryDatabase *hdb)
+{
+    pthread_mutex_lock(&hdb_lock);
+    for (int k=0; k<node_count; k++)
+    {
+        free(nodes[k].ring);
+        nodes[k].ring = NULL;
+    }
+    node_count = 0;
+    pthread_mutex_unlock(&hdb_lock);
+}
+
+// The continuation point holds the number of the next entry to be returned.
+// Requests to be served from the archive set archived and return,
+// hdb_lock must be held.
+static UA_StatusCode read_node(
+    UA_Server *server,
+    const hdb_node *node,
+    const UA_ReadRawModifiedDetails *details,
+    UA_TimestampsToReturn timestampsToReturn,
+    const UA_ByteString *continuationPoint,
+    UA_HistoryReadResult *result,
+    UA_HistoryData *data,
+    bool *archived)
+{
+    *archived = false;
+    UA_DateTime start = details->startTime;
+    UA_DateTime end = details->endTime;
+    if ((start == 0) && (end == 0)) return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if (((start == 0) || (end == 0)) && (details->numValuesPerNode == 0))
+        return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if (details->returnBounds) return UA_STATUSCODE_BADBOUNDNOTSUPPORTED;
+
+    // forward : start <= t < end, reverse : end < t <= start
+    // with only one of the limits the values are read from there on
+    bool reverse = (start == 0) || ((end != 0) && (start > end));
+
+    // Requests reaching back beyond the oldest entry of the ring are served from the archive.
+    // Reading back from a time without a start limit needs more values than the ring holds.
+    if (continuationPoint->length == ARCHIVE_CONTINUATION)
+    {
+        *archived = true;
+        return UA_STATUSCODE_GOOD;
+    }
+    if ((continuationPoint->length == 0) && archive_covers(&node->id))
+    {
+        bool beyond;
+        if (node->written == 0)
+            beyond = true;
+        else if (!reverse)
+            beyond = (start < entry_time(node, oldest(node)));
+        else if ((start != 0) && (end != 0))
+            beyond = (end < entry_time(node, oldest(node)));
+        else
+            beyond = (search(node, (start == 0) ? end : start, true) - oldest(node) < details->numValuesPerNode);
+        if (beyond)
+        {
+            *archived = true;
+            return UA_STATUSCODE_GOOD;
+        }
+    }
+
+    uint64_t first, limit;
+    if (!reverse)
+    {
+        first = search(node, start, false);
+        limit = (end == 0) ? node->written : search(node, end, false);
+    }
+    else
+    {
+        UA_DateTime from = (start == 0) ? end : start;
+        first = search(node, from, true);       // one behind the first entry to return
+        limit = ((start == 0) || (end == 0)) ? oldest(node) : search(node, end, true);
+    }
+
+    // continue a previous request
+    if (continuationPoint->length > 0)
+    {
+        if (continuationPoint->length != sizeof(uint64_t))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&first, continuationPoint->data, sizeof(uint64_t));
+        // entries overwritten in the meantime are skipped
+        if (first < oldest(node)) first = oldest(node);
+    }
+
+    uint64_t available = reverse ? ((first > limit) ? first - limit : 0)
+                                 : ((limit > first) ? limit - first : 0);
+    uint64_t n = available;
+    UA_UInt32 max = details->numValuesPerNode;
+    UA_UInt32 server_max = UA_Server_getConfig(server)->maxReturnDataValues;
+    if ((server_max > 0) && ((max == 0) || (server_max < max))) max = server_max;
+    if ((max > 0) && (n > max)) n = max;
+
+    if (n > 0)
+    {
+        data->dataValues = (UA_DataValue *) UA_Array_new(n, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if (data->dataValues == NULL) return UA_STATUSCODE_BADOUTOFMEMORY;
+        data->dataValuesSize = n;
+    }
+    for (uint64_t i=0; i<n; i++)
+    {
+        uint64_t j = reverse ? first - 1 - i : first + i;
+        const hdb_entry *entry = &node->ring[j % node->length];
+        UA_DataValue *dv = &data->dataValues[i];
+        UA_Variant_setScalarCopy(&dv->value, &entry->value, node->type);
+        dv->hasValue = true;
+        if ((timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE) || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH))
+        {
+            dv->sourceTimestamp = entry->time;
+            dv->hasSourceTimestamp = true;
+        }
+        if ((timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER) || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH))
+        {
+            dv->serverTimestamp = entry->time;
+            dv->hasServerTimestamp = true;
+        }
+    }
+
+    // more data available
+    if (n < available)
+    {
+        uint64_t next = reverse ? first - n : first + n;
+        UA_StatusCode retval = UA_ByteString_allocBuffer(&result->continuationPoint, sizeof(uint64_t));
+        if (retval != UA_STATUSCODE_GOOD) return retval;
+        memcpy(result->continuationPoint.data, &next, sizeof(uint64_t));
+    }
+    return (n == 0) ? UA_STATUSCODE_GOODNODATA : UA_STATUSCODE_GOOD;
+}
+
+static void hdb_read_raw(
+    UA_Server *server, void *hdbContext,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_RequestHeader *requestHeader,
+    const UA_ReadRawModifiedDetails *historyReadDetails,
+    UA_TimestampsToReturn timestampsToReturn,
+    UA_Boolean releaseContinuationPoints,
+    size_t nodesToReadSize,
+    const UA_HistoryReadValueId *nodesToRead,
+    UA_HistoryReadResponse *response,
+    UA_HistoryData * const * const historyData)
+{
+    // the continuation points hold no resources
+    if (releaseContinuationPoints) return;
+    for (size_t i=0; i<nodesToReadSize; i++)
+    {
+        // the values are never modified
+        if (historyReadDetails->isReadModified)
+        {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+            continue;
+        }
+        // variables without a ring are only held in the archive
+        bool archived = true;
+        pthread_mutex_lock(&hdb_lock);
+        const hdb_node *node = find_node(&nodesToRead[i].nodeId);
+        const UA_DataType *type = (node != NULL) ? node->type : archive_type(&nodesToRead[i].nodeId);
+        if (node != NULL)
+            response->results[i].statusCode = read_node(server, node, historyReadDetails,
+                timestampsToReturn, &nodesToRead[i].continuationPoint, &response->results[i], historyData[i], &archived);
+        pthread_mutex_unlock(&hdb_lock);
+        if (type == NULL)
+        {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+            continue;
+        }
+        // the archive is read without holding hdb_lock, the stream reader is not blocked
+        if (archived)
+            response->results[i].statusCode = archive_read(server, &nodesToRead[i].nodeId, type, historyReadDetails,
+                timestampsToReturn, &nodesToRead[i].continuationPoint, &response->results[i], historyData[i]);
+    }
+}
+
+/***********************************/
+/* processed history               */
+/***********************************/
+
+static bool aggregate_supported(const UA_NodeId *aggregate)
+{
+    if ((aggregate->namespaceIndex != 0) || (aggregate->identifierType != UA_NODEIDTYPE_NUMERIC)) return false;
+    switch (aggregate->identifier.numeric)
+    {
+        case UA_NS0ID_AGGREGATEFUNCTION_AVERAGE:
+        case UA_NS0ID_AGGREGATEFUNCTION_MINIMUM:
+        case UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM:
+        case UA_NS0ID_AGGREGATEFUNCTION_RANGE:
+        case UA_NS0ID_AGGREGATEFUNCTION_COUNT:
+        case UA_NS0ID_AGGREGATEFUNCTION_STANDARDDEVIATIONSAMPLE:
+        case UA_NS0ID_AGGREGATEFUNCTION_STANDARDDEVIATIONPOPULATION:
+        case UA_NS0ID_AGGREGATEFUNCTION_VARIANCESAMPLE:
+        case UA_NS0ID_AGGREGATEFUNCTION_VARIANCEPOPULATION:
+            return true;
+        default:
+            return false;
+    }
+}
+
+// the value of the aggregate for one interval
+static void aggregate_value(UA_UInt32 aggregate, const archive_summary *s, UA_DataValue *dv)
+{
+    if (aggregate == UA_NS0ID_AGGREGATEFUNCTION_COUNT)
+    {
+        UA_Int32 count = (UA_Int32) s->count;
+        UA_Variant_setScalarCopy(&dv->value, &count, &UA_TYPES[UA_TYPES_INT32]);
+        dv->hasValue = true;
+        return;
+    }
+    if (s->count == 0)
+    {
+        dv->status = UA_STATUSCODE_BADNODATA;
+        dv->hasStatus = true;
+        return;
+    }
+    double n = (double) s->count;
+    double value;
+    switch (aggregate)
+    {
+        case UA_NS0ID_AGGREGATEFUNCTION_MINIMUM: value = s->min; break;
+        case UA_NS0ID_AGGREGATEFUNCTION_MAXIMUM: value = s->max; break;
+        case UA_NS0ID_AGGREGATEFUNCTION_RANGE: value = s->max - s->min; break;
+        case UA_NS0ID_AGGREGATEFUNCTION_VARIANCEPOPULATION: value = s->m2 / n; break;
+        case UA_NS0ID_AGGREGATEFUNCTION_VARIANCESAMPLE: value = (n > 1.0) ? s->m2 / (n - 1.0) : 0.0; break;
+        case UA_NS0ID_AGGREGATEFUNCTION_STANDARDDEVIATIONPOPULATION: value = sqrt(s->m2 / n); break;
+        case UA_NS0ID_AGGREGATEFUNCTION_STANDARDDEVIATIONSAMPLE: value = (n > 1.0) ? sqrt(s->m2 / (n - 1.0)) : 0.0; break;
+        default: value = s->mean; break;
+    }
+    UA_Variant_setScalarCopy(&dv->value, &value, &UA_TYPES[UA_TYPES_DOUBLE]);
+    dv->hasValue = true;
+}
+
+// add the entries of the ring with from <= t < to to the summary
+static void ring_aggregate(const hdb_node *node, UA_DateTime from, UA_DateTime to, archive_summary *s)
+{
+    uint64_t last = search(node, to, false);
+    for (uint64_t j=search(node, from, false); j<last; j++)
+        archive_summary_add(s, archive_value(&node->ring[j % node->length].value, node->type->typeId.identifier.numeric));
+}
+
+// The range from the start to the end time is divided into intervals of
+// processingInterval, the last one may be shorter. Forward an interval
+// includes its start time and excludes its end, reverse (start > end) the
+// intervals are counted back from the start time and include their later end.
+// The values before the oldest entry of the ring are aggregated from the archive,
+// all values of variables without a ring (node = NULL). hdb_lock is only
+// taken while reading the ring, never while the archive is read.
+// The continuation point holds the number of the next interval.
+static UA_StatusCode process_node(
+    UA_Server *server,
+    const UA_NodeId *id,
+    const UA_DataType *type,
+    const hdb_node *node,
+    const UA_ReadProcessedDetails *details,
+    const UA_NodeId *aggregate,
+    UA_TimestampsToReturn timestampsToReturn,
+    const UA_ByteString *continuationPoint,
+    UA_HistoryReadResult *result,
+    UA_HistoryData *data)
+{
+    UA_DateTime start = details->startTime;
+    UA_DateTime end = details->endTime;
+    if ((start == 0) || (end == 0) || (start == end)) return UA_STATUSCODE_BADINVALIDTIMESTAMPARGUMENT;
+    if (!aggregate_supported(aggregate)) return UA_STATUSCODE_BADAGGREGATENOTSUPPORTED;
+    bool reverse = (start > end);
+    UA_DateTime span = reverse ? start - end : end - start;
+    UA_DateTime interval = (UA_DateTime)(details->processingInterval * UA_DATETIME_MSEC);
+    if ((interval <= 0) || (interval > span)) interval = span;
+    // computed without overflow for time ranges up to the limits of UA_DateTime
+    uint64_t intervals = span / interval + ((span % interval) ? 1 : 0);
+
+    uint64_t first = 0;
+    if (continuationPoint->length > 0)
+    {
+        if (continuationPoint->length != sizeof(uint64_t))
+            return UA_STATUSCODE_BADCONTINUATIONPOINTINVALID;
+        memcpy(&first, continuationPoint->data, sizeof(uint64_t));
+        if (first > intervals) first = intervals;
+    }
+    uint64_t n = intervals - first;
+    UA_UInt32 max = UA_Server_getConfig(server)->maxReturnDataValues;
+    if ((max == 0) || (max > HDB_MAX_INTERVALS)) max = HDB_MAX_INTERVALS;
+    if (n > max) n = max;
+
+    // the ring holds all values from split on
+    bool archived = (node == NULL) || archive_covers(id);
+    UA_DateTime split = UA_INT64_MAX;
+    if (node != NULL)
+    {
+        pthread_mutex_lock(&hdb_lock);
+        if (node->written > 0) split = entry_time(node, oldest(node));
+        pthread_mutex_unlock(&hdb_lock);
+    }
+    if (n > 0)
+    {
+        data->dataValues = (UA_DataValue *) UA_Array_new(n, &UA_TYPES[UA_TYPES_DATAVALUE]);
+        if (data->dataValues == NULL) return UA_STATUSCODE_BADOUTOFMEMORY;
+        data->dataValuesSize = n;
+    }
+    for (uint64_t i=0; i<n; i++)
+    {
+        uint64_t k = first + i;
+        // the interval from <= t < to with its timestamp
+        UA_DateTime from, to, time;
+        if (!reverse)
+        {
+            from = start + k * interval;
+            to = (end - from > interval) ? from + interval : end;
+            time = from;
+        }
+        else
+        {
+            time = start - k * interval;
+            to = time + 1;
+            from = (time - end > interval) ? time - interval + 1 : end + 1;
+        }
+        archive_summary s;
+        archive_summary_init(&s);
+        UA_DateTime ring_from = from;
+        if (archived && (from < split))
+        {
+            UA_StatusCode retval = archive_aggregate(id, type, from, (to < split) ? to : split, &s);
+            if (retval != UA_STATUSCODE_GOOD) return retval;
+            ring_from = split;
+        }
+        if ((node != NULL) && (to > ring_from))
+        {
+            pthread_mutex_lock(&hdb_lock);
+            ring_aggregate(node, ring_from, to, &s);
+            pthread_mutex_unlock(&hdb_lock);
+        }
+        UA_DataValue *dv = &data->dataValues[i];
+        aggregate_value(aggregate->identifier.numeric, &s, dv);
+        if ((timestampsToReturn == UA_TIMESTAMPSTORETURN_SOURCE) || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH))
+        {
+            dv->sourceTimestamp = time;
+            dv->hasSourceTimestamp = true;
+        }
+        if ((timestampsToReturn == UA_TIMESTAMPSTORETURN_SERVER) || (timestampsToReturn == UA_TIMESTAMPSTORETURN_BOTH))
+        {
+            dv->serverTimestamp = time;
+            dv->hasServerTimestamp = true;
+        }
+    }
+
+    // more intervals to be returned
+    if (first + n < intervals)
+    {
+        uint64_t next = first + n;
+        UA_StatusCode retval = UA_ByteString_allocBuffer(&result->continuationPoint, sizeof(uint64_t));
+        if (retval != UA_STATUSCODE_GOOD) return retval;
+        memcpy(result->continuationPoint.data, &next, sizeof(uint64_t));
+    }
+    return UA_STATUSCODE_GOOD;
+}
+
+static void hdb_read_processed(
+    UA_Server *server, void *hdbContext,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_RequestHeader *requestHeader,
+    const UA_ReadProcessedDetails *historyReadDetails,
+    UA_TimestampsToReturn timestampsToReturn,
+    UA_Boolean releaseContinuationPoints,
+    size_t nodesToReadSize,
+    const UA_HistoryReadValueId *nodesToRead,
+    UA_HistoryReadResponse *response,
+    UA_HistoryData * const * const historyData)
+{
+    // the continuation points hold no resources
+    if (releaseContinuationPoints) return;
+    for (size_t i=0; i<nodesToReadSize; i++)
+    {
+        // one aggregate for every node
+        if (historyReadDetails->aggregateTypeSize != nodesToReadSize)
+        {
+            response->results[i].statusCode = UA_STATUSCODE_BADAGGREGATELISTMISMATCH;
+            continue;
+        }
+        // the nodes are registered at the start, their id and type never change
+        pthread_mutex_lock(&hdb_lock);
+        const hdb_node *node = find_node(&nodesToRead[i].nodeId);
+        pthread_mutex_unlock(&hdb_lock);
+        const UA_DataType *type = (node != NULL) ? node->type : archive_type(&nodesToRead[i].nodeId);
+        if (type == NULL)
+        {
+            response->results[i].statusCode = UA_STATUSCODE_BADHISTORYOPERATIONUNSUPPORTED;
+            continue;
+        }
+        response->results[i].statusCode = process_node(server, &nodesToRead[i].nodeId, type, node, historyReadDetails,
+            &historyReadDetails->aggregateType[i], timestampsToReturn,
+            &nodesToRead[i].continuationPoint, &response->results[i], historyData[i]);
+    }
+    pthread_mutex_unlock(&hdb_lock);
+}
+
+UA_HistoryDatabase hdb_database()
+{
+    UA_HistoryDatabase hdb;
+    memset(&hdb, 0, sizeof(UA_HistoryDatabase));
+    hdb.clear = hdb_clear;
+    // the values are recorded by hdb_process(), not from the writes of the server
+    hdb.setValue = NULL;
+    hdb.readRaw = hdb_read_raw;
+    hdb.readProcessed = hdb_read_processed;
+    return hdb;
+}
@@ -0,0 +1,91 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_hdb.h
+  OpcUaServer : history database of the stream variables
+  Version 0.2 2026/10/19
+
+  A history database plugin of the OPC UA server keeping the values of the
+  registered variables in memory. Every variable has a ring which is
+  allocated when it is registered. The entries are recorded by the stream
+  reader for every batch of accepted pulses, independent of the push updates.
+  Values within the stream snapshot (the push variables of pulse_push.h and
+  the pulse rate) are recorded for every pulse with its ingest time, in a
+  ring of HDB_LENGTH entries. All other variables (the results of the
+  processing stages) are recorded after every batch when their value has
+  changed, with the ingest time of the last pulse of the batch, in a ring of
+  HDB_SAMPLED_LENGTH entries.
+
+  HistoryReadRaw is supported with start and end time (forward and reverse),
+  a maximum number of values per node and continuation points.
+  ReadModified is not supported, the values are never modified.
+  The entries of a ring are ordered by time, the start of a request
+  is found by a binary search. Bounding values are not supported.
+  Requests reaching back beyond the ring are passed to the archive (pulse_archive.h).
+  Variables without a ring, the device settings, are read from the archive only.
+
+  HistoryReadProcessed is supported with the aggregates Average, Minimum,
+  Maximum, Range, Count, StandardDeviationSample/Population and
+  VarianceSample/Population. The values older than the ring are taken from the
+  partial aggregates of the archive. All values are Good, the aggregate
+  configuration is ignored. Minimum and Maximum are returned as Double.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEHDB_H
+#define PULSEHDB_H
+
+#include "pulse_snapshot.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// maximum number of historized variables
+#define HDB_NODES 256
+// number of values kept per variable recorded with every pulse
+#define HDB_LENGTH 16384
+// number of values kept per variable recorded on changes
+#define HDB_SAMPLED_LENGTH 4096
+// maximum number of processed intervals returned by one request
+#define HDB_MAX_INTERVALS 65536
+
+// register a variable to be historized, var points to its value
+// the node has to be created with historizing=true and history read access
+void hdb_register(UA_NodeId id, const void *var, const UA_DataType *type);
+
+// record the values of a batch of accepted pulses - called by the stream reader
+// after all processing stages
+void hdb_process(const pulse_snapshot *states, int count);
+
+// the database plugin, to be set as historyDatabase of the server configuration
+UA_HistoryDatabase hdb_database();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
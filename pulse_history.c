@@ -0,0 +1,205 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_history.c
+  OpcUaServer : history of the last pulses
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pulse_history.h"
+
+int32_t history_columns[HISTORY_COLUMNS] = {
+    0, 1, 2, 3, 4, 5, 6, 7, 8, 9, 10, 11, 12, 13, 14, 15,
+    HISTORY_TIME, HISTORY_SEQUENCE, HISTORY_TRIGGER, HISTORY_TRIGGER_OFFSET };
+
+/***********************************/
+/* the ring                        */
+/***********************************/
+
+// Written by the stream reader thread.
+// ring_next is the index where the next entry will be written,
+// ring_fill the number of valid entries (up to HISTORY_LENGTH).
+static int32_t ring_value[HISTORY_TIME][HISTORY_LENGTH];
+static UA_DateTime ring_time[HISTORY_LENGTH];
+static uint64_t ring_sequence[HISTORY_LENGTH];
+static uint64_t ring_trigger[HISTORY_LENGTH];
+static int64_t ring_trigger_offset[HISTORY_LENGTH];
+static int ring_next = 0;
+static int ring_fill = 0;
+static pthread_mutex_t history_lock = PTHREAD_MUTEX_INITIALIZER;
+
+void history_process(const pulse_data *blocks, const pulse_info *info, int count)
+{
+    pthread_mutex_lock(&history_lock);
+    for (int k=0; k<count; k++)
+    {
+        const int32_t *v = (const int32_t *)&blocks[k];
+        for (int c=0; c<HISTORY_TIME; c++)
+            ring_value[c][ring_next] = v[c];
+        ring_time[ring_next] = info[k].timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+        ring_sequence[ring_next] = info[k].sequence;
+        ring_trigger[ring_next] = info[k].trigger;
+        ring_trigger_offset[ring_next] = info[k].trigger_offset;
+        ring_next++;
+        if (ring_next == HISTORY_LENGTH) ring_next = 0;
+        if (ring_fill < HISTORY_LENGTH) ring_fill++;
+    }
+    pthread_mutex_unlock(&history_lock);
+}
+
+/***********************************/
+/* the copy served to the clients  */
+/***********************************/
+
+// only accessed by the server thread
+// the columns are ordered from the oldest to the newest pulse
+static int32_t copy_value[HISTORY_TIME][HISTORY_LENGTH];
+static UA_DateTime copy_time[HISTORY_LENGTH];
+static uint64_t copy_sequence[HISTORY_LENGTH];
+static uint64_t copy_trigger[HISTORY_LENGTH];
+static int64_t copy_trigger_offset[HISTORY_LENGTH];
+static int copy_fill = 0;
+static bool copy_valid = false;
+
+void history_invalidate()
+{
+    copy_valid = false;
+}
+
+// copy one column in two pieces : from start to the end and from 0 to ring_next
+static void copy_column(void *copy, const void *ring, size_t size, int start, int first, int second)
+{
+    memcpy(copy, (const char *)ring + start * size, first * size);
+    memcpy((char *)copy + first * size, ring, second * size);
+}
+
+// copy the ring in two pieces per column : from ring_next to the end and from 0 to ring_next
+static void history_take()
+{
+    if (copy_valid) return;
+    pthread_mutex_lock(&history_lock);
+    int start = 0;
+    int first = ring_fill;
+    if (ring_fill == HISTORY_LENGTH)
+    {
+        start = ring_next;
+        first = HISTORY_LENGTH - ring_next;
+    }
+    int second = ring_fill - first;
+    for (int c=0; c<HISTORY_TIME; c++)
+        copy_column(copy_value[c], ring_value[c], sizeof(int32_t), start, first, second);
+    copy_column(copy_time, ring_time, sizeof(UA_DateTime), start, first, second);
+    copy_column(copy_sequence, ring_sequence, sizeof(uint64_t), start, first, second);
+    copy_column(copy_trigger, ring_trigger, sizeof(uint64_t), start, first, second);
+    copy_column(copy_trigger_offset, ring_trigger_offset, sizeof(int64_t), start, first, second);
+    copy_fill = ring_fill;
+    pthread_mutex_unlock(&history_lock);
+    copy_valid = true;
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    if (nodeContext == NULL) return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    int column = *(int32_t *)nodeContext;
+    if ((column < 0) || (column >= HISTORY_COLUMNS)) return UA_STATUSCODE_BADCONFIGURATIONERROR;
+    history_take();
+
+    const UA_DataType *type;
+    char *data;
+    switch (column)
+    {
+        case HISTORY_TIME:
+            type = &UA_TYPES[UA_TYPES_DATETIME];
+            data = (char *)copy_time;
+            break;
+        case HISTORY_SEQUENCE:
+            type = &UA_TYPES[UA_TYPES_UINT64];
+            data = (char *)copy_sequence;
+            break;
+        case HISTORY_TRIGGER:
+            type = &UA_TYPES[UA_TYPES_UINT64];
+            data = (char *)copy_trigger;
+            break;
+        case HISTORY_TRIGGER_OFFSET:
+            type = &UA_TYPES[UA_TYPES_INT64];
+            data = (char *)copy_trigger_offset;
+            break;
+        default:
+            type = &UA_TYPES[UA_TYPES_INT32];
+            data = (char *)copy_value[column];
+    }
+
+    // select the slice requested by the index range
+    size_t first = 0;
+    size_t n = copy_fill;
+    if (range != NULL)
+    {
+        if ((range->dimensionsSize != 1) || (range->dimensions[0].min > range->dimensions[0].max))
+        {
+            dataValue->hasStatus = true;
+            dataValue->status = UA_STATUSCODE_BADINDEXRANGEINVALID;
+            return UA_STATUSCODE_GOOD;
+        }
+        if (range->dimensions[0].min >= n)
+        {
+            dataValue->hasStatus = true;
+            dataValue->status = UA_STATUSCODE_BADINDEXRANGENODATA;
+            return UA_STATUSCODE_GOOD;
+        }
+        first = range->dimensions[0].min;
+        size_t last = range->dimensions[0].max;
+        if (last >= n) last = n - 1;
+        n = last - first + 1;
+    }
+
+    // zero-copy : the variant points into the copy, which stays unchanged
+    // until the next iteration of the main loop
+    if (n > 0)
+        UA_Variant_setArray(&dataValue->value, data + first * type->memSize, n, type);
+    else
+        UA_Variant_setArray(&dataValue->value, UA_EMPTY_ARRAY_SENTINEL, 0, type);
+    dataValue->value.storageType = UA_VARIANT_DATA_NODELETE;
+    dataValue->hasValue = true;
+    if (sourceTimeStamp && (copy_fill > 0))
+    {
+        dataValue->sourceTimestamp = copy_time[copy_fill-1];
+        dataValue->hasSourceTimestamp = true;
+    }
+    return UA_STATUSCODE_GOOD;
+}
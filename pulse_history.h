@@ -0,0 +1,94 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_history.h
+  OpcUaServer : history of the last pulses
+  Version 0.2 2026/10/19
+
+  The values of all pulses passing the outlier rejection and the coincidence
+  filter are kept in a ring of HISTORY_LENGTH entries, one column per field
+  of pulse_data, one column of ingest times and the columns of the sequence
+  number, the associated trigger and the offset from this trigger.
+  Every column is available as an array variable ordered from the oldest
+  to the newest pulse.
+
+  The arrays are served from a copy of the ring which is taken with the first
+  history read in every iteration of the server main loop (like the stream
+  snapshot in pulse_snapshot.h). The reads return a pointer into this copy
+  without copying the values again. An index range given by the client
+  is applied to the copy, only the requested slice is encoded.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEHISTORY_H
+#define PULSEHISTORY_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of pulses kept
+#define HISTORY_LENGTH 4096
+
+// the columns : the 16 fields of pulse_data in their order, the time,
+// the sequence number, the trigger index and the trigger offset
+#define HISTORY_TIME (PULSE_CHANNELS*PULSE_FIELDS)
+#define HISTORY_SEQUENCE (HISTORY_TIME+1)
+#define HISTORY_TRIGGER (HISTORY_TIME+2)
+#define HISTORY_TRIGGER_OFFSET (HISTORY_TIME+3)
+#define HISTORY_COLUMNS (HISTORY_TIME+4)
+
+// the column indices used as node context
+extern int32_t history_columns[HISTORY_COLUMNS];
+
+// append a batch of data blocks - called by the stream reader
+void history_process(const pulse_data *blocks, const pulse_info *info, int count);
+
+// to be called by the server main loop before every iteration
+void history_invalidate();
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// read one column, nodeContext points to the column index
+// Int32 for the fields, DateTime for the time column,
+// UInt64 for the sequence and trigger index, Int64 for the trigger offset
+UA_StatusCode read_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
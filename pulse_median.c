@@ -0,0 +1,291 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_median.c
+  OpcUaServer : sliding-window median and outlier rejection
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+
+#include "pulse_median.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t median_mode = MEDIAN_MODE_FLAG;
+int32_t median_window = 101;
+float median_k = 5.0f;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+pulse_data median_value;
+pulse_data median_mad;
+int32_t median_outliers[PULSE_CHANNELS] = { 0, 0, 0, 0 };
+int32_t median_rejected = 0;
+
+/***********************************/
+/* double heap median              */
+/***********************************/
+
+// The window contents are kept in the ring buffer data[].
+// The heap array is addressed with indices from -N/2 to (N-1)/2 :
+// heap[0] is the median, the positive indices form a min-heap of the
+// values above, the negative indices a max-heap of the values below it.
+// The children of index i are 2i and 2i+1 (2i and 2i-1 for negative i).
+// pos[] holds the heap index of every ring buffer entry.
+typedef struct {
+    int32_t *data;
+    int *pos;
+    int *heap_base;
+    int *heap;          // points to the center of heap_base
+    int N;              // window length
+    int idx;            // ring buffer index of the next entry
+    int ct;             // number of entries
+} mediator;
+
+static bool mediator_init(mediator *m, int n)
+{
+    m->data = (int32_t *) calloc(n, sizeof(int32_t));
+    m->pos = (int *) calloc(n, sizeof(int));
+    m->heap_base = (int *) calloc(n, sizeof(int));
+    if ((m->data == NULL) || (m->pos == NULL) || (m->heap_base == NULL))
+        return false;
+    m->heap = m->heap_base + n/2;
+    m->N = n;
+    m->idx = 0;
+    m->ct = 0;
+    // the ring buffer entries are assigned alternately to the max- and min-heap
+    for (int i=n-1; i>=0; i--)
+    {
+        m->pos[i] = ((i+1)/2) * ((i&1) ? -1 : 1);
+        m->heap[m->pos[i]] = i;
+    }
+    return true;
+}
+
+static void mediator_free(mediator *m)
+{
+    free(m->data);
+    free(m->pos);
+    free(m->heap_base);
+    m->data = NULL;
+    m->pos = NULL;
+    m->heap_base = NULL;
+    m->heap = NULL;
+}
+
+static inline int min_count(const mediator *m) { return (m->ct-1)/2; }
+static inline int max_count(const mediator *m) { return m->ct/2; }
+
+static inline bool heap_less(const mediator *m, int i, int j)
+{
+    return m->data[m->heap[i]] < m->data[m->heap[j]];
+}
+
+// exchange the heap entries i and j if entry i is less than j
+static bool heap_compare_exchange(mediator *m, int i, int j)
+{
+    if (!heap_less(m, i, j)) return false;
+    int t = m->heap[i];
+    m->heap[i] = m->heap[j];
+    m->heap[j] = t;
+    m->pos[m->heap[i]] = i;
+    m->pos[m->heap[j]] = j;
+    return true;
+}
+
+// move an entry down the min-heap, i is the first child index to check
+// starting at i=1 the median itself is checked against the min-heap
+static void min_sort_down(mediator *m, int i)
+{
+    for (; i <= min_count(m); i *= 2)
+    {
+        if ((i > 1) && (i < min_count(m)) && heap_less(m, i+1, i)) i++;
+        if (!heap_compare_exchange(m, i, i/2)) break;
+    }
+}
+
+// move an entry down the max-heap, i is the first child index to check
+// starting at i=-1 the median itself is checked against the max-heap
+static void max_sort_down(mediator *m, int i)
+{
+    for (; i >= -max_count(m); i *= 2)
+    {
+        if ((i < -1) && (i > -max_count(m)) && heap_less(m, i, i-1)) i--;
+        if (!heap_compare_exchange(m, i/2, i)) break;
+    }
+}
+
+// move an entry up the min-heap, returns true if it reached the median
+static bool min_sort_up(mediator *m, int i)
+{
+    while ((i > 0) && heap_compare_exchange(m, i, i/2)) i /= 2;
+    return (i == 0);
+}
+
+// move an entry up the max-heap, returns true if it reached the median
+static bool max_sort_up(mediator *m, int i)
+{
+    while ((i < 0) && heap_compare_exchange(m, i/2, i)) i /= 2;
+    return (i == 0);
+}
+
+// insert a value replacing the oldest one once the window is full
+static void mediator_insert(mediator *m, int32_t v)
+{
+    bool is_new = (m->ct < m->N);
+    int p = m->pos[m->idx];
+    int32_t old = m->data[m->idx];
+    m->data[m->idx] = v;
+    m->idx = (m->idx + 1) % m->N;
+    if (is_new) m->ct++;
+    if (p > 0)
+    {
+        // the entry is in the min-heap
+        if (!is_new && (old < v))
+            min_sort_down(m, p*2);
+        else if (min_sort_up(m, p))
+            max_sort_down(m, -1);
+    }
+    else if (p < 0)
+    {
+        // the entry is in the max-heap
+        if (!is_new && (v < old))
+            max_sort_down(m, p*2);
+        else if (max_sort_up(m, p))
+            min_sort_down(m, 1);
+    }
+    else
+    {
+        // the entry is the median
+        if (max_count(m)) max_sort_down(m, -1);
+        if (min_count(m)) min_sort_down(m, 1);
+    }
+}
+
+// the window length is always odd, so the median is one of the entries
+static inline int32_t mediator_median(const mediator *m)
+{
+    return m->data[m->heap[0]];
+}
+
+/***********************************/
+/* filters for all values          */
+/***********************************/
+
+#define MEDIAN_VALUES (PULSE_CHANNELS*PULSE_FIELDS)
+
+static mediator value_filter[MEDIAN_VALUES];
+static mediator deviation_filter[MEDIAN_VALUES];
+// the window length the filters are allocated for, 0 if not allocated
+static int filter_window = 0;
+
+static void filters_free()
+{
+    for (int j=0; j<MEDIAN_VALUES; j++)
+    {
+        mediator_free(&value_filter[j]);
+        mediator_free(&deviation_filter[j]);
+    }
+    filter_window = 0;
+}
+
+// (re-)allocate all filters if the configured window length has changed
+static bool filters_setup()
+{
+    int n = median_window;
+    if (n < 1) n = 1;
+    if (n > MEDIAN_WINDOW_MAX) n = MEDIAN_WINDOW_MAX;
+    if ((n & 1) == 0) n++;
+    if (n == filter_window) return true;
+    filters_free();
+    for (int j=0; j<MEDIAN_VALUES; j++)
+    {
+        if (!mediator_init(&value_filter[j], n) || !mediator_init(&deviation_filter[j], n))
+        {
+            printf("OpcUaServer : median filter allocation failed\n");
+            filters_free();
+            return false;
+        }
+    }
+    filter_window = n;
+    return true;
+}
+
+void median_process(const pulse_data *blocks, pulse_info *info, int count)
+{
+    if (median_mode == MEDIAN_MODE_OFF)
+    {
+        if (filter_window != 0) filters_free();
+        return;
+    }
+    if (!filters_setup()) return;
+    float k = median_k;
+    int32_t *med = (int32_t *) &median_value;
+    int32_t *mad = (int32_t *) &median_mad;
+
+    for (int b=0; b<count; b++)
+    {
+        const int32_t *raw = (const int32_t *) &blocks[b];
+        bool outlier = false;
+        bool channel_outlier[PULSE_CHANNELS] = { false, false, false, false };
+        for (int j=0; j<MEDIAN_VALUES; j++)
+        {
+            mediator *vf = &value_filter[j];
+            mediator *df = &deviation_filter[j];
+            // test against the window before the value is inserted
+            bool full = (vf->ct == vf->N);
+            int32_t m = full ? mediator_median(vf) : 0;
+            int32_t d = full ? mediator_median(df) : 0;
+            int64_t dev = (int64_t)raw[j] - m;
+            if (dev < 0) dev = -dev;
+            // a MAD of zero is raised to one count to tolerate the ADC resolution
+            if (full && ((float)dev > k * (float)((d > 0) ? d : 1)))
+            {
+                outlier = true;
+                channel_outlier[j / PULSE_FIELDS] = true;
+            }
+            // all values enter the window, a real step will be followed after half the window
+            mediator_insert(vf, raw[j]);
+            m = mediator_median(vf);
+            dev = (int64_t)raw[j] - m;
+            if (dev < 0) dev = -dev;
+            mediator_insert(df, (dev > INT32_MAX) ? INT32_MAX : (int32_t)dev);
+            med[j] = m;
+            mad[j] = mediator_median(df);
+        }
+        if (outlier)
+        {
+            info[b].flags |= PULSE_FLAG_OUTLIER;
+            for (int ch=0; ch<PULSE_CHANNELS; ch++)
+                if (channel_outlier[ch]) median_outliers[ch]++;
+        }
+    }
+}
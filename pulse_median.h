@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_median.h
+  OpcUaServer : sliding-window median and outlier rejection
+  Version 0.2 2026/10/19
+
+  For every channel and field the median over the last median_window
+  pulses is kept. The median absolute deviation (MAD) is approximated by
+  the sliding median of the deviations of every pulse from the median
+  at the time of its arrival. A pulse deviating by more than
+  median_k * MAD from the median in any of the 16 values is an outlier.
+
+  Both medians are kept in a double heap (max-heap below and min-heap
+  above the median sharing one array) indexed by a ring buffer of the
+  window contents. Replacing the oldest value costs O(log n).
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEMEDIAN_H
+#define PULSEMEDIAN_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define MEDIAN_MODE_OFF 0
+#define MEDIAN_MODE_FLAG 1
+#define MEDIAN_MODE_REJECT 2
+
+// largest accepted window length
+#define MEDIAN_WINDOW_MAX 4095
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t median_mode;             // one of MEDIAN_MODE_*
+extern int32_t median_window;           // window length [pulses], rounded up to odd
+extern float median_k;                  // outlier limit in units of the MAD
+
+//*************************************
+// results
+//*************************************
+
+// median and MAD for every channel and field, same layout as pulse_data
+extern pulse_data median_value;
+extern pulse_data median_mad;
+// number of outliers detected per channel
+extern int32_t median_outliers[PULSE_CHANNELS];
+// number of pulses rejected
+extern int32_t median_rejected;
+
+// update the medians with a batch of data blocks and flag the outliers
+// outliers are flagged with PULSE_FLAG_OUTLIER (only after the window has been filled)
+void median_process(const pulse_data *blocks, pulse_info *info, int count);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,307 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_position.c
+  OpcUaServer : beam position from the pulse data
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "pulse_position.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t position_geometry = POSITION_GEOMETRY_DIAGONAL;
+int32_t position_field = FIELD_SUM;
+float position_kx = 10.0f;
+float position_ky = 10.0f;
+float position_offset_x = 0.0f;
+float position_offset_y = 0.0f;
+float position_gain[PULSE_CHANNELS] = { 1.0f, 1.0f, 1.0f, 1.0f };
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+int32_t position_count = 0;
+float position_x_mean = 0.0f;
+float position_x_rms = 0.0f;
+float position_y_mean = 0.0f;
+float position_y_rms = 0.0f;
+float position_intensity_mean = 0.0f;
+float position_intensity_rms = 0.0f;
+int32_t position_invalid = 0;
+
+/***********************************/
+/* position history                */
+/***********************************/
+
+// The history is kept as separate arrays for X, Y and intensity.
+// hist_next is the index where the next entry will be written,
+// hist_fill the number of valid entries (up to POSITION_HISTORY).
+// The sums over the window are updated incrementally,
+// they are recomputed from scratch every time the index wraps around
+// to avoid the accumulation of rounding errors.
+static float hist_x[POSITION_HISTORY];
+static float hist_y[POSITION_HISTORY];
+static float hist_i[POSITION_HISTORY];
+static int hist_next = 0;
+static int hist_fill = 0;
+static double sum_x, sum_xx, sum_y, sum_yy, sum_i, sum_ii;
+// the position of the last pulse with signal, only used by the stream reader thread
+static pulse_position last_valid = { 0.0f, 0.0f, 0.0f };
+
+// the history is written by the stream reader thread
+// and read by the server thread
+static pthread_mutex_t position_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void recompute_sums()
+{
+    sum_x = sum_xx = sum_y = sum_yy = sum_i = sum_ii = 0.0;
+    for (int k=0; k<hist_fill; k++)
+    {
+        sum_x += hist_x[k];
+        sum_xx += (double)hist_x[k] * hist_x[k];
+        sum_y += hist_y[k];
+        sum_yy += (double)hist_y[k] * hist_y[k];
+        sum_i += hist_i[k];
+        sum_ii += (double)hist_i[k] * hist_i[k];
+    }
+}
+
+static void history_append(float x, float y, float i)
+{
+    if (hist_fill == POSITION_HISTORY)
+    {
+        // remove the oldest entry from the sums
+        float ox = hist_x[hist_next];
+        float oy = hist_y[hist_next];
+        float oi = hist_i[hist_next];
+        sum_x -= ox;
+        sum_xx -= (double)ox * ox;
+        sum_y -= oy;
+        sum_yy -= (double)oy * oy;
+        sum_i -= oi;
+        sum_ii -= (double)oi * oi;
+    }
+    else
+        hist_fill++;
+    hist_x[hist_next] = x;
+    hist_y[hist_next] = y;
+    hist_i[hist_next] = i;
+    sum_x += x;
+    sum_xx += (double)x * x;
+    sum_y += y;
+    sum_yy += (double)y * y;
+    sum_i += i;
+    sum_ii += (double)i * i;
+    hist_next++;
+    if (hist_next == POSITION_HISTORY)
+    {
+        hist_next = 0;
+        recompute_sums();
+    }
+}
+
+static float window_rms(double sum, double sumsq, int n)
+{
+    double mean = sum / n;
+    double var = sumsq / n - mean * mean;
+    return (var > 0.0) ? (float)sqrt(var) : 0.0f;
+}
+
+/***********************************/
+/* batch processing                */
+/***********************************/
+
+// The batch is first converted into one array per electrode.
+// All computations are then done in simple loops over these arrays
+// which the compiler can vectorize (NEON on the instrument CPU).
+// Pulses without signal get a zero weight and are flagged invalid.
+
+#define POSITION_BATCH 64
+
+static void position_process_chunk(const pulse_data *blocks, pulse_position *positions, int n)
+{
+    float a[POSITION_BATCH], b[POSITION_BATCH], c[POSITION_BATCH], d[POSITION_BATCH];
+    float x[POSITION_BATCH], y[POSITION_BATCH], inten[POSITION_BATCH];
+    int valid[POSITION_BATCH];
+
+    // take a copy of the configuration, it may be modified by the server at any time
+    int field = position_field;
+    if ((field < 0) || (field >= PULSE_FIELDS)) field = FIELD_SUM;
+    int geometry = position_geometry;
+    float kx = position_kx;
+    float ky = position_ky;
+    float x0 = position_offset_x;
+    float y0 = position_offset_y;
+    float g1 = position_gain[0];
+    float g2 = position_gain[1];
+    float g3 = position_gain[2];
+    float g4 = position_gain[3];
+
+    // gather the electrode signals
+    for (int k=0; k<n; k++)
+    {
+        a[k] = g1 * (float)PULSE_VALUE(&blocks[k], 0, field);
+        b[k] = g2 * (float)PULSE_VALUE(&blocks[k], 1, field);
+        c[k] = g3 * (float)PULSE_VALUE(&blocks[k], 2, field);
+        d[k] = g4 * (float)PULSE_VALUE(&blocks[k], 3, field);
+    }
+
+    // difference over sum
+    if (geometry == POSITION_GEOMETRY_ORTHOGONAL)
+    {
+        for (int k=0; k<n; k++)
+        {
+            float sx = a[k] + c[k];
+            float sy = b[k] + d[k];
+            float inv_x = (sx > 0.0f) ? 1.0f / sx : 0.0f;
+            float inv_y = (sy > 0.0f) ? 1.0f / sy : 0.0f;
+            x[k] = kx * (a[k] - c[k]) * inv_x + x0;
+            y[k] = ky * (b[k] - d[k]) * inv_y + y0;
+            inten[k] = sx + sy;
+            valid[k] = (sx > 0.0f) & (sy > 0.0f);
+        }
+    }
+    else
+    {
+        for (int k=0; k<n; k++)
+        {
+            float sigma = a[k] + b[k] + c[k] + d[k];
+            float inv = (sigma > 0.0f) ? 1.0f / sigma : 0.0f;
+            x[k] = kx * ((a[k] + d[k]) - (b[k] + c[k])) * inv + x0;
+            y[k] = ky * ((a[k] + b[k]) - (c[k] + d[k])) * inv + y0;
+            inten[k] = sigma;
+            valid[k] = (sigma > 0.0f);
+        }
+    }
+
+    // append the valid pulses to the history
+    pthread_mutex_lock(&position_lock);
+    int invalid = 0;
+    for (int k=0; k<n; k++)
+    {
+        if (valid[k])
+        {
+            history_append(x[k], y[k], inten[k]);
+            last_valid.x = x[k];
+            last_valid.y = y[k];
+            last_valid.intensity = inten[k];
+        }
+        else
+            invalid++;
+        positions[k] = last_valid;
+    }
+    pthread_mutex_unlock(&position_lock);
+
+    // publish the results
+    position_invalid += invalid;
+    if (hist_fill > 0)
+    {
+        position_x_mean = (float)(sum_x / hist_fill);
+        position_x_rms = window_rms(sum_x, sum_xx, hist_fill);
+        position_y_mean = (float)(sum_y / hist_fill);
+        position_y_rms = window_rms(sum_y, sum_yy, hist_fill);
+        position_intensity_mean = (float)(sum_i / hist_fill);
+        position_intensity_rms = window_rms(sum_i, sum_ii, hist_fill);
+        position_count = hist_fill;
+    }
+}
+
+void position_process(const pulse_data *blocks, pulse_position *positions, int count)
+{
+    while (count > 0)
+    {
+        int n = (count > POSITION_BATCH) ? POSITION_BATCH : count;
+        position_process_chunk(blocks, positions, n);
+        blocks += n;
+        positions += n;
+        count -= n;
+    }
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/* read methods for the history    */
+/***********************************/
+
+// copy the history ring into an array ordered from the oldest to the newest entry
+static UA_StatusCode read_history(const float *ring, UA_DataValue *dataValue)
+{
+    pthread_mutex_lock(&position_lock);
+    size_t n = hist_fill;
+    UA_Float *data = (UA_Float *) UA_Array_new(n, &UA_TYPES[UA_TYPES_FLOAT]);
+    if ((n > 0) && (data == NULL))
+    {
+        pthread_mutex_unlock(&position_lock);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    size_t start = (hist_fill == POSITION_HISTORY) ? hist_next : 0;
+    for (size_t k=0; k<n; k++)
+        data[k] = ring[(start + k) % POSITION_HISTORY];
+    pthread_mutex_unlock(&position_lock);
+    UA_Variant_setArray(&dataValue->value, data, n, &UA_TYPES[UA_TYPES_FLOAT]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
+
+UA_StatusCode read_position_x_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    return read_history(hist_x, dataValue);
+}
+
+UA_StatusCode read_position_y_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    return read_history(hist_y, dataValue);
+}
+
+UA_StatusCode read_position_intensity_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    return read_history(hist_i, dataValue);
+}
@@ -0,0 +1,137 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_position.h
+  OpcUaServer : beam position from the pulse data
+  Version 0.2 2026/10/19
+
+  The 4 inputs are used as pick-up electrodes. For every pulse
+  the beam position is computed from the difference-over-sum
+  of the (gain corrected) electrode signals.
+
+  Electrode geometry POSITION_GEOMETRY_DIAGONAL (button pick-up) :
+  Ch1 upper right, Ch2 upper left, Ch3 lower left, Ch4 lower right
+    X = kx * ((Ch1+Ch4)-(Ch2+Ch3)) / (Ch1+Ch2+Ch3+Ch4)
+    Y = ky * ((Ch1+Ch2)-(Ch3+Ch4)) / (Ch1+Ch2+Ch3+Ch4)
+
+  Electrode geometry POSITION_GEOMETRY_ORTHOGONAL (stripline pick-up) :
+  Ch1 right, Ch2 top, Ch3 left, Ch4 bottom
+    X = kx * (Ch1-Ch3) / (Ch1+Ch3)
+    Y = ky * (Ch2-Ch4) / (Ch2+Ch4)
+
+  The intensity is the sum of all 4 gain corrected signals.
+  A pulse without signal keeps the position of the previous pulse.
+  The position of every pulse is published with its data block
+  in the stream snapshot (pulse_snapshot.h).
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEPOSITION_H
+#define PULSEPOSITION_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define POSITION_GEOMETRY_DIAGONAL 0
+#define POSITION_GEOMETRY_ORTHOGONAL 1
+
+// number of pulses kept in the position history
+// the statistics are computed over the same window
+#define POSITION_HISTORY 1024
+
+// beam position of one pulse
+typedef struct {
+    float x;                    // [mm]
+    float y;                    // [mm]
+    float intensity;
+} pulse_position;
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t position_geometry;       // one of POSITION_GEOMETRY_*
+extern int32_t position_field;          // pulse data field used as signal FIELD_*
+extern float position_kx;               // geometry factor X [mm]
+extern float position_ky;               // geometry factor Y [mm]
+extern float position_offset_x;         // electrical offset X [mm]
+extern float position_offset_y;         // electrical offset Y [mm]
+extern float position_gain[PULSE_CHANNELS];
+
+//*************************************
+// results
+//*************************************
+
+// statistics over the history window
+extern int32_t position_count;
+extern float position_x_mean;
+extern float position_x_rms;
+extern float position_y_mean;
+extern float position_y_rms;
+extern float position_intensity_mean;
+extern float position_intensity_rms;
+// pulses without signal where no position could be computed
+extern int32_t position_invalid;
+
+// compute the positions for a batch of data blocks
+void position_process(const pulse_data *blocks, pulse_position *positions, int count);
+
+/***********************************/
+/* OPC-UA data source              */
+/* read methods for the history    */
+/***********************************/
+
+UA_StatusCode read_position_x_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+UA_StatusCode read_position_y_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+UA_StatusCode read_position_intensity_history(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
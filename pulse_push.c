@@ -0,0 +1,182 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_push.c
+  OpcUaServer : stream variables updated on arrival of new data
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <pthread.h>
+
+#include "pulse_push.h"
+#include "pulse_snapshot.h"
+
+float push_max_rate = 10.0f;
+int32_t push_lossless = 0;
+uint32_t push_updates = 0;
+uint32_t push_dropped = 0;
+
+// The variables are registered with the offset of their value within
+// the snapshot. They can be written from stream_snapshot or from
+// any queued state of the same layout.
+typedef struct {
+    UA_NodeId id;
+    size_t offset;
+    const UA_DataType *type;
+} push_node;
+
+static push_node nodes[PUSH_NODES];
+static int node_count = 0;
+
+// only accessed by the server thread
+static UA_DateTime last_push = 0;
+static int64_t last_timestamp = 0;
+
+void push_register(UA_NodeId id, const void *var, const UA_DataType *type)
+{
+    const char *base = (const char *)&stream_snapshot;
+    if (((const char *)var < base) || ((const char *)var + type->memSize > base + sizeof(pulse_snapshot)))
+    {
+        printf("OpcUaServer : push variable not within the stream snapshot\n");
+        return;
+    }
+    if (node_count == PUSH_NODES)
+    {
+        printf("OpcUaServer : too many push variables, increase PUSH_NODES\n");
+        return;
+    }
+    nodes[node_count].id = id;
+    nodes[node_count].offset = (const char *)var - base;
+    nodes[node_count].type = type;
+    node_count++;
+}
+
+// write all variables from one state
+static void push_write(UA_Server *server, const pulse_snapshot *state)
+{
+    UA_DataValue value;
+    UA_DataValue_init(&value);
+    value.hasValue = true;
+    value.sourceTimestamp = state->timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+    value.hasSourceTimestamp = true;
+    for (int k=0; k<node_count; k++)
+    {
+        UA_Variant_setScalar(&value.value, (char *)state + nodes[k].offset, nodes[k].type);
+        UA_Server_writeDataValue(server, nodes[k].id, value);
+    }
+    push_updates++;
+}
+
+/***********************************/
+/* queue for the lossless mode     */
+/***********************************/
+
+// written by the stream reader thread, emptied by the server thread
+static pulse_snapshot queue[PUSH_QUEUE];
+static int queue_head = 0;      // next entry to be written
+static int queue_fill = 0;
+static pthread_mutex_t push_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// Every accepted block is queued with its calibrated values.
+void push_process(const pulse_snapshot *states, int count)
+{
+    if (!push_lossless) return;
+    pthread_mutex_lock(&push_lock);
+    for (int k=0; k<count; k++)
+    {
+        if (queue_fill == PUSH_QUEUE)
+        {
+            push_dropped++;
+            continue;
+        }
+        queue[queue_head] = states[k];
+        queue_head = (queue_head + 1) % PUSH_QUEUE;
+        queue_fill++;
+    }
+    pthread_mutex_unlock(&push_lock);
+}
+
+// write the queued blocks, taken from the queue in chunks
+// so the stream reader is not blocked while the variables are written
+// At most PUSH_DRAIN blocks are written per call, the remaining ones
+// are left for the next tick so the server thread is not held up.
+#define PUSH_CHUNK 64
+
+static void push_drain(UA_Server *server)
+{
+    pulse_snapshot pending[PUSH_CHUNK];
+    for (int written=0; written<PUSH_DRAIN; written+=PUSH_CHUNK)
+    {
+        pthread_mutex_lock(&push_lock);
+        int n = (queue_fill > PUSH_CHUNK) ? PUSH_CHUNK : queue_fill;
+        int start = (queue_head - queue_fill + PUSH_QUEUE) % PUSH_QUEUE;
+        for (int i=0; i<n; i++)
+            pending[i] = queue[(start + i) % PUSH_QUEUE];
+        queue_fill -= n;
+        pthread_mutex_unlock(&push_lock);
+        if (n == 0) return;
+        for (int i=0; i<n; i++)
+            push_write(server, &pending[i]);
+        last_timestamp = pending[n-1].timestamp;
+    }
+}
+
+/***********************************/
+/* periodic update                 */
+/***********************************/
+
+static void push_callback(UA_Server *server, void *data)
+{
+    if (push_lossless)
+    {
+        push_drain(server);
+        return;
+    }
+    // discard blocks left over after the lossless mode was switched off
+    pthread_mutex_lock(&push_lock);
+    queue_fill = 0;
+    pthread_mutex_unlock(&push_lock);
+
+    float rate = push_max_rate;
+    if (rate <= 0.0f) return;
+    UA_DateTime now = UA_DateTime_nowMonotonic();
+    if ((last_push != 0) && (now - last_push < (UA_DateTime)(UA_DATETIME_SEC / rate))) return;
+
+    // the snapshot of the current main loop iteration
+    snapshot_take();
+    if ((stream_snapshot.timestamp == 0) || (stream_snapshot.timestamp == last_timestamp)) return;
+    push_write(server, &stream_snapshot);
+    last_push = now;
+    last_timestamp = stream_snapshot.timestamp;
+}
+
+UA_StatusCode push_start(UA_Server *server)
+{
+    UA_StatusCode retval = UA_Server_addRepeatedCallback(server, push_callback, NULL, PUSH_TICK, NULL);
+    if (retval != UA_STATUSCODE_GOOD)
+        printf("OpcUaServer : failed to add the push callback %8x\n", retval);
+    return retval;
+}
@@ -0,0 +1,106 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_push.h
+  OpcUaServer : stream variables updated on arrival of new data
+  Version 0.2 2026/10/19
+
+  Internal variables marked with push="true" in variables.xml are created
+  as variables holding their value instead of data sources. Their values are
+  written from the stream snapshot (pulse_snapshot.h) whenever a new data block
+  has been published, but not more often than push_max_rate per second.
+  The source timestamp is the ingest time of the block. Only the blocks
+  passing the outlier rejection and the coincidence filter are pushed,
+  in both modes.
+
+  The monitored items of these variables are notified when new data arrive
+  and are not served by a callback on every sampling interval.
+
+  In the lossless mode (push_lossless=1) every data block is queued by the
+  stream reader and the variables are written once per block, regardless of
+  push_max_rate. Monitored items with sampling interval 0 are sampled on every
+  write, with a queue size > 1 they receive all blocks between two Publish
+  responses. A queue overflow sets the overflow bit of the notification and
+  is counted in the diagnostics of the subscription (MonitoringQueueOverflowCount).
+  Blocks which do not fit into the queue of the server are counted in push_dropped.
+  At most PUSH_DRAIN blocks are written per tick, the remaining ones stay queued.
+
+  The variable Pulse (pulse_type.h) carries the complete block with its
+  sequence number, so every write changes its value. The scalar variables
+  are written separately and repeat their values for many blocks (the flags,
+  constant channels). With the default data change trigger STATUS_VALUE
+  equal values are not reported. Clients which need every block from the
+  scalar variables must use the trigger STATUS_VALUE_TIMESTAMP, the source
+  timestamp is the ingest time of the block.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEPUSH_H
+#define PULSEPUSH_H
+
+#include "pulse_snapshot.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// maximum number of push variables
+#define PUSH_NODES 64
+// check for new data every 10 ms
+#define PUSH_TICK 10
+// number of data blocks queued for the lossless mode
+#define PUSH_QUEUE 4096
+// maximum number of data blocks written per tick in the lossless mode
+#define PUSH_DRAIN 512
+
+// maximum number of updates per second - writable through the OPC UA server
+// values <= 0 stop the updates
+extern float push_max_rate;
+
+// write every data block - writable through the OPC UA server
+extern int32_t push_lossless;
+
+// number of updates since the server start
+extern uint32_t push_updates;
+// data blocks lost in the lossless mode because the queue was full
+extern uint32_t push_dropped;
+
+// register a variable to be updated from the snapshot
+// var points to the value in stream_snapshot, type is its data type
+void push_register(UA_NodeId id, const void *var, const UA_DataType *type);
+
+// queue the states of a batch of accepted data blocks
+// for the lossless mode - called by the stream reader
+void push_process(const pulse_snapshot *states, int count);
+
+// start the periodic updates
+UA_StatusCode push_start(UA_Server *server);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,328 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_quantile.c
+  OpcUaServer : streaming quantiles of the pulse amplitudes
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <math.h>
+#include <pthread.h>
+
+#include "pulse_quantile.h"
+
+float quantile_minute[QUANTILE_STREAMS][QUANTILE_LEVELS];
+float quantile_hour[QUANTILE_STREAMS][QUANTILE_LEVELS];
+float quantile_day[QUANTILE_STREAMS][QUANTILE_LEVELS];
+
+static const double quantile_level[QUANTILE_LEVELS] = { 0.5, 0.9, 0.99, 0.999 };
+
+/***********************************/
+/* t-digest                        */
+/***********************************/
+
+// The compression limits the number of centroids to about TDIGEST_COMPRESSION.
+// Single values are collected in a buffer and merged when the buffer is full.
+#define TDIGEST_COMPRESSION 200.0
+#define TDIGEST_CENTROIDS 256
+#define TDIGEST_BUFFER 512
+#define TDIGEST_PI 3.14159265358979323846
+
+typedef struct {
+    double mean;
+    double weight;
+} centroid;
+
+typedef struct {
+    int n;                              // number of centroids
+    double total;                       // total weight
+    double min;                         // smallest and largest value seen
+    double max;
+    centroid c[TDIGEST_CENTROIDS];      // sorted by mean
+} tdigest;
+
+static void tdigest_reset(tdigest *d)
+{
+    d->n = 0;
+    d->total = 0.0;
+    d->min = INFINITY;
+    d->max = -INFINITY;
+}
+
+static int centroid_compare(const void *a, const void *b)
+{
+    double ma = ((const centroid *)a)->mean;
+    double mb = ((const centroid *)b)->mean;
+    return (ma > mb) - (ma < mb);
+}
+
+// scale function k(q) and its inverse
+static double k_scale(double q)
+{
+    return TDIGEST_COMPRESSION / (2.0 * TDIGEST_PI) * asin(2.0 * q - 1.0);
+}
+static double k_inverse(double k)
+{
+    return (sin(k * 2.0 * TDIGEST_PI / TDIGEST_COMPRESSION) + 1.0) / 2.0;
+}
+
+// merge additional centroids (or single values with weight 1) into the digest
+// Neighbouring centroids are combined as long as the combined centroid
+// spans less than one unit of the scale function.
+static void tdigest_compress(tdigest *d, const centroid *extra, int nextra)
+{
+    centroid all[TDIGEST_CENTROIDS + TDIGEST_BUFFER];
+    if (nextra > TDIGEST_BUFFER) nextra = TDIGEST_BUFFER;
+    int n = d->n;
+    memcpy(all, d->c, n * sizeof(centroid));
+    for (int i=0; i<nextra; i++)
+    {
+        all[n++] = extra[i];
+        d->total += extra[i].weight;
+        if (extra[i].mean < d->min) d->min = extra[i].mean;
+        if (extra[i].mean > d->max) d->max = extra[i].mean;
+    }
+    if (n == 0) return;
+    qsort(all, n, sizeof(centroid), centroid_compare);
+
+    double total = d->total;
+    double weight_before = 0.0;
+    double q_limit = k_inverse(k_scale(0.0) + 1.0) * total;
+    int out = 0;
+    d->c[0] = all[0];
+    for (int i=1; i<n; i++)
+    {
+        centroid *cur = &d->c[out];
+        if ((weight_before + cur->weight + all[i].weight <= q_limit) || (out == TDIGEST_CENTROIDS-1))
+        {
+            // combine into the current centroid
+            cur->weight += all[i].weight;
+            cur->mean += (all[i].mean - cur->mean) * all[i].weight / cur->weight;
+        }
+        else
+        {
+            weight_before += cur->weight;
+            q_limit = k_inverse(k_scale(weight_before / total) + 1.0) * total;
+            d->c[++out] = all[i];
+        }
+    }
+    d->n = out + 1;
+}
+
+// merge the digest src into dst
+static void tdigest_merge(tdigest *dst, const tdigest *src)
+{
+    if (src->n == 0) return;
+    tdigest_compress(dst, src->c, src->n);
+    if (src->min < dst->min) dst->min = src->min;
+    if (src->max > dst->max) dst->max = src->max;
+}
+
+// the values between the centers of the centroids are interpolated linearly
+static double tdigest_quantile(const tdigest *d, double q)
+{
+    if (d->n == 0) return NAN;
+    if (d->n == 1) return d->c[0].mean;
+    double index = q * d->total;
+    const centroid *c = d->c;
+    double half = c[0].weight / 2.0;
+    if (index < half)
+        return d->min + (c[0].mean - d->min) * index / half;
+    double cum = half;
+    for (int i=0; i<d->n-1; i++)
+    {
+        double dw = (c[i].weight + c[i+1].weight) / 2.0;
+        if (index < cum + dw)
+            return c[i].mean + (c[i+1].mean - c[i].mean) * (index - cum) / dw;
+        cum += dw;
+    }
+    const centroid *last = &c[d->n-1];
+    double rest = d->total - cum;
+    if ((rest <= 0.0) || (index >= d->total)) return d->max;
+    return last->mean + (d->max - last->mean) * (index - cum) / rest;
+}
+
+/***********************************/
+/* windows                         */
+/***********************************/
+
+#define QUANTILE_MINUTES 60
+#define QUANTILE_HOURS 24
+
+typedef struct {
+    tdigest current;                            // filled by the stream
+    centroid buffer[TDIGEST_BUFFER];            // values not yet merged into current
+    int nbuf;
+    tdigest minutes[QUANTILE_MINUTES];          // the last 60 complete minutes
+    tdigest hours[QUANTILE_HOURS];              // the last 24 complete hours
+} quantile_stream;
+
+static quantile_stream streams[QUANTILE_STREAMS];
+static int minute_next = 0;
+static int minute_fill = 0;
+static int hour_next = 0;
+static int hour_fill = 0;
+static int seconds = 0;
+static int minutes = 0;
+static int initialized = 0;
+
+// the current digests are written by the stream reader thread
+// and rolled over by the timer thread
+static pthread_mutex_t quantile_lock = PTHREAD_MUTEX_INITIALIZER;
+// the published quantiles are written by the timer thread and read by the server
+static pthread_mutex_t quantile_result_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void quantile_init()
+{
+    pthread_mutex_lock(&quantile_lock);
+    if (!initialized)
+    {
+        for (int s=0; s<QUANTILE_STREAMS; s++)
+        {
+            tdigest_reset(&streams[s].current);
+            streams[s].nbuf = 0;
+        }
+        for (int s=0; s<QUANTILE_STREAMS; s++)
+            for (int l=0; l<QUANTILE_LEVELS; l++)
+                quantile_minute[s][l] = quantile_hour[s][l] = quantile_day[s][l] = NAN;
+        initialized = 1;
+    }
+    pthread_mutex_unlock(&quantile_lock);
+}
+
+void quantile_process(const pulse_data *blocks, int count)
+{
+    if (!initialized) quantile_init();
+    pthread_mutex_lock(&quantile_lock);
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+    {
+        quantile_stream *sp = &streams[2*ch];
+        quantile_stream *ss = &streams[2*ch+1];
+        for (int k=0; k<count; k++)
+        {
+            sp->buffer[sp->nbuf].mean = PULSE_VALUE(&blocks[k], ch, FIELD_PEAK);
+            sp->buffer[sp->nbuf].weight = 1.0;
+            ss->buffer[ss->nbuf].mean = PULSE_VALUE(&blocks[k], ch, FIELD_SUM);
+            ss->buffer[ss->nbuf].weight = 1.0;
+            // both buffers are always filled at the same rate
+            if (++sp->nbuf == TDIGEST_BUFFER)
+            {
+                tdigest_compress(&sp->current, sp->buffer, sp->nbuf);
+                tdigest_compress(&ss->current, ss->buffer, ss->nbuf);
+                sp->nbuf = 0;
+            }
+            ss->nbuf = sp->nbuf;
+        }
+    }
+    pthread_mutex_unlock(&quantile_lock);
+}
+
+static void publish(float result[QUANTILE_STREAMS][QUANTILE_LEVELS], int s, const tdigest *d)
+{
+    float q[QUANTILE_LEVELS];
+    for (int l=0; l<QUANTILE_LEVELS; l++)
+        q[l] = (float)tdigest_quantile(d, quantile_level[l]);
+    pthread_mutex_lock(&quantile_result_lock);
+    memcpy(result[s], q, sizeof(q));
+    pthread_mutex_unlock(&quantile_result_lock);
+}
+
+void quantile_update()
+{
+    // the merged digests are only used by the timer thread
+    static tdigest hour;
+    static tdigest day;
+
+    if (!initialized) quantile_init();
+    if (++seconds < 60) return;
+    seconds = 0;
+
+    // store the current digests as the last complete minute
+    pthread_mutex_lock(&quantile_lock);
+    for (int s=0; s<QUANTILE_STREAMS; s++)
+    {
+        quantile_stream *qs = &streams[s];
+        tdigest_compress(&qs->current, qs->buffer, qs->nbuf);
+        qs->nbuf = 0;
+        qs->minutes[minute_next] = qs->current;
+        tdigest_reset(&qs->current);
+    }
+    pthread_mutex_unlock(&quantile_lock);
+    int last_minute = minute_next;
+    minute_next = (minute_next + 1) % QUANTILE_MINUTES;
+    if (minute_fill < QUANTILE_MINUTES) minute_fill++;
+    bool full_hour = (++minutes == QUANTILE_MINUTES);
+    if (full_hour) minutes = 0;
+
+    for (int s=0; s<QUANTILE_STREAMS; s++)
+    {
+        quantile_stream *qs = &streams[s];
+        publish(quantile_minute, s, &qs->minutes[last_minute]);
+        // the hour is the merge of all minutes in the ring
+        tdigest_reset(&hour);
+        for (int m=0; m<minute_fill; m++)
+            tdigest_merge(&hour, &qs->minutes[m]);
+        publish(quantile_hour, s, &hour);
+        if (full_hour)
+        {
+            qs->hours[hour_next] = hour;
+            // the day is the merge of all hours in the ring
+            tdigest_reset(&day);
+            int n = (hour_fill < QUANTILE_HOURS) ? hour_fill+1 : QUANTILE_HOURS;
+            for (int h=0; h<n; h++)
+                tdigest_merge(&day, &qs->hours[h]);
+            publish(quantile_day, s, &day);
+        }
+    }
+    if (full_hour)
+    {
+        hour_next = (hour_next + 1) % QUANTILE_HOURS;
+        if (hour_fill < QUANTILE_HOURS) hour_fill++;
+    }
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_quantiles(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    UA_Float q[QUANTILE_LEVELS];
+    pthread_mutex_lock(&quantile_result_lock);
+    memcpy(q, nodeContext, sizeof(q));
+    pthread_mutex_unlock(&quantile_result_lock);
+    UA_Variant_setArrayCopy(&dataValue->value, q, QUANTILE_LEVELS, &UA_TYPES[UA_TYPES_FLOAT]);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
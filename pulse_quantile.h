@@ -0,0 +1,88 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_quantile.h
+  OpcUaServer : streaming quantiles of the pulse amplitudes
+  Version 0.2 2026/10/19
+
+  The distributions of Ch*_peak and Ch*_sum are kept as t-digests
+  (merging variant with the arcsine scale function) which need a fixed
+  amount of memory and can be merged without loss of accuracy in the tails.
+
+  The stream feeds one digest per value. Once every minute this digest
+  is stored in a ring of 60 minutes, the hour is the merge of this ring.
+  Every full hour the hour digest is stored in a ring of 24 hours,
+  the day is the merge of that ring. For every window the quantiles
+  p50, p90, p99 and p99.9 are published as an array.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSEQUANTILE_H
+#define PULSEQUANTILE_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the values which are tracked : peak and sum of all 4 channels
+// stream index = 2*channel + (0 for peak, 1 for sum)
+#define QUANTILE_STREAMS (2*PULSE_CHANNELS)
+
+// p50, p90, p99, p99.9
+#define QUANTILE_LEVELS 4
+
+// quantiles over the last complete minute, the last 60 minutes and the last 24 hours
+extern float quantile_minute[QUANTILE_STREAMS][QUANTILE_LEVELS];
+extern float quantile_hour[QUANTILE_STREAMS][QUANTILE_LEVELS];
+extern float quantile_day[QUANTILE_STREAMS][QUANTILE_LEVELS];
+
+// add a batch of data blocks to the digests
+void quantile_process(const pulse_data *blocks, int count);
+
+// to be called once every second from the timer thread
+// rolls the windows and computes the quantiles
+void quantile_update();
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// read the quantiles of one window, nodeContext points to the array of QUANTILE_LEVELS values
+UA_StatusCode read_quantiles(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
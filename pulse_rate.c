@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_rate.c
+  OpcUaServer : dead-time corrected pulse rate
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <math.h>
+
+#include "libera_mci.h"      // the MCI access layer
+#include "pulse_rate.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+float rate_clock = 500.0f;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+float rate_deadtime = 0.0f;
+float rate_measured = 0.0f;
+float rate_nonparalyzable = 0.0f;
+float rate_paralyzable = 0.0f;
+float live_fraction_nonparalyzable = 1.0f;
+float live_fraction_paralyzable = 1.0f;
+
+/***********************************/
+/* cached instrument settings      */
+/***********************************/
+
+// dead time in samples, read from MCI by the timer thread
+static uint32_t deadtime_samples = 0;
+static volatile bool rate_stale = true;
+static int seconds_since_check = 0;
+
+bool rate_refresh()
+{
+    uint32_t pre, post, ignore;
+    bool success = true;
+    success &= mci_get_pulse_pretrigger(&pre);
+    success &= mci_get_pulse_posttrigger(&post);
+    success &= mci_get_pulse_ignore_counter(&ignore);
+    if (!success)
+    {
+        printf("MCI value error : dead time refresh\n");
+        return false;
+    }
+    deadtime_samples = pre + post + ignore;
+    return true;
+}
+
+void rate_invalidate()
+{
+    rate_stale = true;
+}
+
+/***********************************/
+/* dead time models                */
+/***********************************/
+
+#define RATE_E 2.718281828459045
+
+// Solve m = n * exp(-n*tau) for the branch n*tau < 1 by Newton iteration.
+// Returns NaN if m exceeds the largest possible measured rate 1/(e*tau).
+static double paralyzable_rate(double m, double tau)
+{
+    if (tau <= 0.0) return m;
+    if (m * tau * RATE_E > 1.0) return NAN;
+    double n = m;
+    for (int i=0; i<50; i++)
+    {
+        double e = exp(-n * tau);
+        double f = n * e - m;
+        double df = e * (1.0 - n * tau);
+        if (df <= 0.0) break;
+        double step = f / df;
+        n -= step;
+        if (fabs(step) < 1e-9 * n) break;
+    }
+    return n;
+}
+
+void rate_update(int32_t pps)
+{
+    seconds_since_check++;
+    if (rate_stale || (seconds_since_check >= RATE_RECHECK))
+    {
+        // keep the stale flag if the refresh failed, it will be retried next second
+        rate_stale = false;
+        if (!rate_refresh())
+            rate_stale = true;
+        seconds_since_check = 0;
+    }
+
+    double clock = (rate_clock > 0.0f) ? rate_clock * 1e6 : 500e6;
+    double tau = (double)deadtime_samples / clock;
+    double m = (double)pps;
+    rate_deadtime = (float)(tau * 1e9);
+    rate_measured = (float)m;
+
+    // non-paralyzable
+    double live = 1.0 - m * tau;
+    if (live > 0.0)
+    {
+        rate_nonparalyzable = (float)(m / live);
+        live_fraction_nonparalyzable = (float)live;
+    }
+    else
+    {
+        rate_nonparalyzable = NAN;
+        live_fraction_nonparalyzable = 0.0f;
+    }
+
+    // paralyzable
+    double n = paralyzable_rate(m, tau);
+    rate_paralyzable = (float)n;
+    live_fraction_paralyzable = (n > 0.0) ? (float)(m / n) : (isnan(n) ? 0.0f : 1.0f);
+}
@@ -0,0 +1,91 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_rate.h
+  OpcUaServer : dead-time corrected pulse rate
+  Version 0.2 2026/10/19
+
+  After every trigger the pulse processing is blind for the trigger window
+  (pretrigger + posttrigger samples) and the hold-off (ignore_counter samples).
+  The dead time is taken as the sum of both, converted with the sample clock.
+  The settings are read over MCI.
+
+  From the measured rate m and the dead time tau the true rate n is estimated
+    non-paralyzable : m = n / (1 + n*tau)     n = m / (1 - m*tau)
+    paralyzable     : m = n * exp(-n*tau)     solved for the low-rate branch
+  There is no estimate from the inter-arrival times of the pulses. The stream
+  carries no device time and the ingest times are dominated by the latency
+  of the stream reader, not by the intervals between the pulses.
+
+  A rate that is not compatible with the model (saturation) is published as NaN.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PULSERATE_H
+#define PULSERATE_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// interval of re-reading the settings from MCI [s]
+#define RATE_RECHECK 10
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern float rate_clock;                // sample clock [MHz]
+
+//*************************************
+// results
+//*************************************
+
+extern float rate_deadtime;             // dead time per pulse [ns]
+extern float rate_measured;             // raw count of the last second [1/s]
+extern float rate_nonparalyzable;       // corrected rate, non-paralyzable model [1/s]
+extern float rate_paralyzable;          // corrected rate, paralyzable model [1/s]
+extern float live_fraction_nonparalyzable;  // fraction of the time the detection was live
+extern float live_fraction_paralyzable;
+
+// read the dead time settings over MCI
+bool rate_refresh();
+
+// force a new reading of the settings with the next update
+void rate_invalidate();
+
+// to be called once every second from the timer thread
+// with the number of pulses received within the last second
+void rate_update(int32_t pps);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,87 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_snapshot.c
+  OpcUaServer : coherent snapshot of the stream variables
+  Version 0.2 2026/10/19
+ */
+
+#include <pthread.h>
+
+#include "pulse_snapshot.h"
+
+pulse_snapshot stream_snapshot;
+
+// the live state, written by the stream reader and the timer thread
+static pulse_snapshot live;
+static pthread_mutex_t snapshot_lock = PTHREAD_MUTEX_INITIALIZER;
+
+// only accessed by the server thread
+static bool snapshot_valid = false;
+
+void snapshot_fill(pulse_snapshot *state, const pulse_data *block, const pulse_info *info,
+                   const pulse_data_calibrated *calibrated, const pulse_position *position, int32_t pps)
+{
+    state->timestamp = info->timestamp;
+    state->pulse.sequence = info->sequence;
+    state->pulse.trigger = info->trigger;
+    state->pulse.trigger_offset = info->trigger_offset;
+    state->pulse.flags = info->flags;
+    state->pulse.block = *block;
+    state->calibrated = *calibrated;
+    state->position = *position;
+    state->pps = pps;
+}
+
+// the block, its calibrated values and its position are updated together
+void snapshot_publish(const pulse_snapshot *state)
+{
+    pthread_mutex_lock(&snapshot_lock);
+    live.timestamp = state->timestamp;
+    live.pulse = state->pulse;
+    live.calibrated = state->calibrated;
+    live.position = state->position;
+    pthread_mutex_unlock(&snapshot_lock);
+}
+
+void snapshot_publish_pps(int32_t pps)
+{
+    pthread_mutex_lock(&snapshot_lock);
+    live.pps = pps;
+    pthread_mutex_unlock(&snapshot_lock);
+}
+
+void snapshot_take()
+{
+    if (snapshot_valid) return;
+    pthread_mutex_lock(&snapshot_lock);
+    stream_snapshot = live;
+    pthread_mutex_unlock(&snapshot_lock);
+    snapshot_valid = true;
+}
+
+void snapshot_invalidate()
+{
+    snapshot_valid = false;
+}
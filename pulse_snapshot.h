@@ -0,0 +1,98 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_snapshot.h
+  OpcUaServer : coherent snapshot of the stream variables
+  Version 0.2 2026/10/19
+
+  The last data block passing the outlier rejection and the coincidence
+  filter is published together with its sequence number, flags, trigger
+  association, calibrated values and beam position by the stream reader
+  in one update. The pulse rate is
+  published by the timer thread. They are served by the OPC UA server
+  from a snapshot of this state.
+
+  The snapshot is taken with the first read of any stream variable within one
+  iteration of the server main loop and is kept until the next iteration.
+  A Read request and the sampling of the monitored items are processed
+  completely within one iteration, so all stream variables of one request
+  (or one publishing cycle) belong to the same data block.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PULSESNAPSHOT_H
+#define PULSESNAPSHOT_H
+
+#include "pulse_data.h"
+#include "pulse_calibration.h"
+#include "pulse_position.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// One pulse with its sequence number, flags and trigger association.
+// This is also the memory layout of the OPC UA data type PulseData (pulse_type.h).
+typedef struct {
+    uint64_t sequence;                  // running number of the block
+    uint64_t trigger;                   // index (t2_count) of the associated trigger
+    int64_t trigger_offset;             // time since the associated trigger [ns]
+    uint32_t flags;                     // its flags PULSE_FLAG_*
+    pulse_data block;                   // the data block
+} pulse_record;
+
+typedef struct {
+    int64_t timestamp;                  // ingest time [ns since 1970-01-01 UTC], 0 before the first block
+    pulse_record pulse;                 // the last accepted data block
+    pulse_data_calibrated calibrated;   // its calibrated values
+    pulse_position position;            // its beam position
+    int32_t pps;                        // pulses received in the last second
+} pulse_snapshot;
+
+// the snapshot served by the server, to be accessed from the server thread only
+extern pulse_snapshot stream_snapshot;
+
+// fill the state of one block, also used for the states queued for the push updates
+void snapshot_fill(pulse_snapshot *state, const pulse_data *block, const pulse_info *info,
+                   const pulse_data_calibrated *calibrated, const pulse_position *position, int32_t pps);
+
+// publish a new state - called by the stream reader and the timer thread
+// the pulse rate of the state is not published, it is set by snapshot_publish_pps()
+void snapshot_publish(const pulse_snapshot *state);
+void snapshot_publish_pps(int32_t pps);
+
+// to be called by the read methods of all stream variables
+// takes a new snapshot if none was taken in the current main loop iteration
+void snapshot_take();
+
+// to be called by the server main loop before every iteration
+void snapshot_invalidate();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,285 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_topk.c
+  OpcUaServer : retention of the largest pulses
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <string.h>
+#include <pthread.h>
+
+#include "pulse_topk.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t topk_k = 10;
+int32_t topk_field = FIELD_PEAK;
+int32_t topk_period = 3600;
+
+/***********************************/
+/* bounded min-heap                */
+/***********************************/
+
+typedef struct {
+    int32_t value;          // the ranking value
+    pulse_info info;
+    pulse_data block;
+} topk_entry;
+
+// e[0] is the smallest retained entry
+typedef struct {
+    int n;
+    topk_entry e[TOPK_MAX];
+} topk_heap;
+
+static topk_heap current[PULSE_CHANNELS];
+static topk_heap previous[PULSE_CHANNELS];
+// the configuration the current lists are collected with
+static int active_k = 0;
+static int active_field = -1;
+static int seconds = 0;
+
+// the lists are written by the stream reader thread, rolled over by the
+// timer thread and read by the server thread
+static pthread_mutex_t topk_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void heap_swap(topk_heap *h, int i, int j)
+{
+    topk_entry t = h->e[i];
+    h->e[i] = h->e[j];
+    h->e[j] = t;
+}
+
+static void heap_sift_up(topk_heap *h, int i)
+{
+    while (i > 0)
+    {
+        int parent = (i-1)/2;
+        if (h->e[i].value >= h->e[parent].value) break;
+        heap_swap(h, i, parent);
+        i = parent;
+    }
+}
+
+static void heap_sift_down(topk_heap *h, int i)
+{
+    while (true)
+    {
+        int smallest = i;
+        int l = 2*i+1;
+        int r = 2*i+2;
+        if ((l < h->n) && (h->e[l].value < h->e[smallest].value)) smallest = l;
+        if ((r < h->n) && (h->e[r].value < h->e[smallest].value)) smallest = r;
+        if (smallest == i) break;
+        heap_swap(h, i, smallest);
+        i = smallest;
+    }
+}
+
+// a pulse equal to the smallest retained one does not replace it,
+// so the earlier pulse wins a tie
+static void heap_offer(topk_heap *h, int k, int32_t value, const pulse_data *block, const pulse_info *info)
+{
+    if (h->n < k)
+    {
+        topk_entry *e = &h->e[h->n];
+        e->value = value;
+        e->info = *info;
+        e->block = *block;
+        heap_sift_up(h, h->n++);
+    }
+    else if (value > h->e[0].value)
+    {
+        h->e[0].value = value;
+        h->e[0].info = *info;
+        h->e[0].block = *block;
+        heap_sift_down(h, 0);
+    }
+}
+
+/***********************************/
+/* stream processing               */
+/***********************************/
+
+void topk_process(const pulse_data *blocks, const pulse_info *info, int count)
+{
+    int k = topk_k;
+    if (k < 1) k = 1;
+    if (k > TOPK_MAX) k = TOPK_MAX;
+    int field = (topk_field == FIELD_SUM) ? FIELD_SUM : FIELD_PEAK;
+
+    pthread_mutex_lock(&topk_lock);
+    // a change of the configuration restarts the collection
+    if ((k != active_k) || (field != active_field))
+    {
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+            current[ch].n = 0;
+        active_k = k;
+        active_field = field;
+        seconds = 0;
+    }
+    for (int ch=0; ch<PULSE_CHANNELS; ch++)
+        for (int b=0; b<count; b++)
+            heap_offer(&current[ch], k, PULSE_VALUE(&blocks[b], ch, field), &blocks[b], &info[b]);
+    pthread_mutex_unlock(&topk_lock);
+}
+
+void topk_update()
+{
+    pthread_mutex_lock(&topk_lock);
+    seconds++;
+    if ((topk_period > 0) && (seconds >= topk_period))
+    {
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+        {
+            previous[ch] = current[ch];
+            current[ch].n = 0;
+        }
+        seconds = 0;
+    }
+    pthread_mutex_unlock(&topk_lock);
+}
+
+/***********************************/
+/* OPC-UA method                   */
+/***********************************/
+
+// sort by descending value, equal values by ascending time
+static int entry_compare(const void *a, const void *b)
+{
+    const topk_entry *ea = (const topk_entry *)a;
+    const topk_entry *eb = (const topk_entry *)b;
+    if (ea->value != eb->value) return (ea->value < eb->value) ? 1 : -1;
+    return (ea->info.sequence > eb->info.sequence) - (ea->info.sequence < eb->info.sequence);
+}
+
+// inputs : channel (1..4), previous period
+// outputs : values, ingest times, sequence numbers, data blocks (16 values per pulse),
+//           t2 trigger indices, offsets from the triggers
+static UA_StatusCode GetTopPulses(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *methodId, void *methodContext,
+    const UA_NodeId *objectId, void *objectContext,
+    size_t inputSize, const UA_Variant *input,
+    size_t outputSize, UA_Variant *output)
+{
+    if (!UA_Variant_hasScalarType(&input[0], &UA_TYPES[UA_TYPES_UINT32]) ||
+        !UA_Variant_hasScalarType(&input[1], &UA_TYPES[UA_TYPES_BOOLEAN]))
+        return UA_STATUSCODE_BADINVALIDARGUMENT;
+    UA_UInt32 channel = *(UA_UInt32 *)input[0].data;
+    UA_Boolean prev = *(UA_Boolean *)input[1].data;
+    if ((channel < 1) || (channel > PULSE_CHANNELS))
+        return UA_STATUSCODE_BADOUTOFRANGE;
+
+    topk_entry list[TOPK_MAX];
+    pthread_mutex_lock(&topk_lock);
+    const topk_heap *h = prev ? &previous[channel-1] : &current[channel-1];
+    size_t n = h->n;
+    memcpy(list, h->e, n * sizeof(topk_entry));
+    pthread_mutex_unlock(&topk_lock);
+    qsort(list, n, sizeof(topk_entry), entry_compare);
+
+    UA_Int32 *values = (UA_Int32 *) UA_Array_new(n, &UA_TYPES[UA_TYPES_INT32]);
+    UA_DateTime *times = (UA_DateTime *) UA_Array_new(n, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_UInt64 *sequence = (UA_UInt64 *) UA_Array_new(n, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Int32 *data = (UA_Int32 *) UA_Array_new(n * PULSE_CHANNELS * PULSE_FIELDS, &UA_TYPES[UA_TYPES_INT32]);
+    UA_UInt64 *triggers = (UA_UInt64 *) UA_Array_new(n, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Int64 *offsets = (UA_Int64 *) UA_Array_new(n, &UA_TYPES[UA_TYPES_INT64]);
+    if ((n > 0) && (!values || !times || !sequence || !data || !triggers || !offsets))
+    {
+        UA_Array_delete(values, n, &UA_TYPES[UA_TYPES_INT32]);
+        UA_Array_delete(times, n, &UA_TYPES[UA_TYPES_DATETIME]);
+        UA_Array_delete(sequence, n, &UA_TYPES[UA_TYPES_UINT64]);
+        UA_Array_delete(data, n * PULSE_CHANNELS * PULSE_FIELDS, &UA_TYPES[UA_TYPES_INT32]);
+        UA_Array_delete(triggers, n, &UA_TYPES[UA_TYPES_UINT64]);
+        UA_Array_delete(offsets, n, &UA_TYPES[UA_TYPES_INT64]);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for (size_t i=0; i<n; i++)
+    {
+        values[i] = list[i].value;
+        times[i] = list[i].info.timestamp / 100 + UA_DATETIME_UNIX_EPOCH;
+        sequence[i] = list[i].info.sequence;
+        memcpy(&data[i * PULSE_CHANNELS * PULSE_FIELDS], &list[i].block, BLOCKSIZE);
+        triggers[i] = list[i].info.trigger;
+        offsets[i] = list[i].info.trigger_offset;
+    }
+    UA_Variant_setArray(&output[0], values, n, &UA_TYPES[UA_TYPES_INT32]);
+    UA_Variant_setArray(&output[1], times, n, &UA_TYPES[UA_TYPES_DATETIME]);
+    UA_Variant_setArray(&output[2], sequence, n, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Variant_setArray(&output[3], data, n * PULSE_CHANNELS * PULSE_FIELDS, &UA_TYPES[UA_TYPES_INT32]);
+    UA_Variant_setArray(&output[4], triggers, n, &UA_TYPES[UA_TYPES_UINT64]);
+    UA_Variant_setArray(&output[5], offsets, n, &UA_TYPES[UA_TYPES_INT64]);
+    return UA_STATUSCODE_GOOD;
+}
+
+static UA_Argument make_argument(char *name, char *description, const UA_DataType *type, UA_Int32 valueRank)
+{
+    UA_Argument arg;
+    UA_Argument_init(&arg);
+    arg.name = UA_STRING(name);
+    arg.description = UA_LOCALIZEDTEXT("en_US", description);
+    arg.dataType = type->typeId;
+    arg.valueRank = valueRank;
+    return arg;
+}
+
+UA_StatusCode topk_add_method(UA_Server *server, UA_NodeId parent)
+{
+    UA_Argument inputs[2];
+    inputs[0] = make_argument("Channel", "channel 1..4", &UA_TYPES[UA_TYPES_UINT32], UA_VALUERANK_SCALAR);
+    inputs[1] = make_argument("Previous", "list of the previous period", &UA_TYPES[UA_TYPES_BOOLEAN], UA_VALUERANK_SCALAR);
+    UA_Argument outputs[6];
+    outputs[0] = make_argument("Values", "ranking values in descending order", &UA_TYPES[UA_TYPES_INT32], UA_VALUERANK_ONE_DIMENSION);
+    outputs[1] = make_argument("Timestamps", "ingest times", &UA_TYPES[UA_TYPES_DATETIME], UA_VALUERANK_ONE_DIMENSION);
+    outputs[2] = make_argument("Sequence", "sequence numbers", &UA_TYPES[UA_TYPES_UINT64], UA_VALUERANK_ONE_DIMENSION);
+    outputs[3] = make_argument("Blocks", "16 values of every pulse", &UA_TYPES[UA_TYPES_INT32], UA_VALUERANK_ONE_DIMENSION);
+    outputs[4] = make_argument("Triggers", "index of the associated t2 trigger, 0=none", &UA_TYPES[UA_TYPES_UINT64], UA_VALUERANK_ONE_DIMENSION);
+    outputs[5] = make_argument("TriggerOffsets", "time since the associated trigger [ns]", &UA_TYPES[UA_TYPES_INT64], UA_VALUERANK_ONE_DIMENSION);
+
+    UA_MethodAttributes attr = UA_MethodAttributes_default;
+    attr.description = UA_LOCALIZEDTEXT("en_US", "ranked list of the largest pulses of a channel");
+    attr.displayName = UA_LOCALIZEDTEXT("en_US", "GetTopPulses");
+    attr.executable = true;
+    attr.userExecutable = true;
+    return UA_Server_addMethodNode(
+            server,
+            UA_NODEID_STRING(1, "GetTopPulses"),
+            parent,
+            UA_NS0ID(HASCOMPONENT),
+            UA_QUALIFIEDNAME(1, "GetTopPulses"),
+            attr,
+            &GetTopPulses,
+            2, inputs,
+            6, outputs,
+            NULL,
+            NULL);
+}
@@ -0,0 +1,76 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_topk.h
+  OpcUaServer : retention of the largest pulses
+  Version 0.2 2026/10/19
+
+  For every channel the topk_k largest pulses (by peak or sum)
+  are retained together with the complete data block, the ingest time
+  and the sequence number. The pulses are kept in a bounded min-heap,
+  a new pulse only has to be compared with the smallest retained one.
+
+  The collection runs over a period of topk_period seconds. At the end
+  of the period the list is kept as the previous one and a new collection
+  is started. The ranked lists are returned by the method GetTopPulses.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSETOPK_H
+#define PULSETOPK_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// the largest number of pulses which can be retained per channel
+#define TOPK_MAX 100
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t topk_k;                  // number of pulses retained per channel
+extern int32_t topk_field;              // ranking field FIELD_PEAK or FIELD_SUM
+extern int32_t topk_period;             // collection period [s], 0 for unlimited
+
+// feed a batch of data blocks into the lists
+void topk_process(const pulse_data *blocks, const pulse_info *info, int count);
+
+// to be called once every second from the timer thread
+void topk_update();
+
+// add the method GetTopPulses to the given folder
+UA_StatusCode topk_add_method(UA_Server *server, UA_NodeId parent);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
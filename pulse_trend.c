@@ -0,0 +1,339 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_trend.c
+  OpcUaServer : long-term trends of the channel baselines and the pulse rate
+  Version 0.2 2026/10/19
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <string.h>
+#include <math.h>
+#include <time.h>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <pthread.h>
+
+#include "pulse_trend.h"
+
+trend_selector trend_select[TREND_LEVELS][TREND_SERIES][TREND_KINDS];
+
+/***********************************/
+/* store layout                    */
+/***********************************/
+
+#define TREND_MAGIC 0x444E5254      // "TRND"
+#define TREND_VERSION 1
+
+#define TREND_CAPACITY_1S 3600
+#define TREND_CAPACITY_1MIN 1440
+#define TREND_CAPACITY_1H 2160
+
+static const int64_t level_seconds[TREND_LEVELS] = { 1, 60, 3600 };
+static const int level_capacity[TREND_LEVELS] = { TREND_CAPACITY_1S, TREND_CAPACITY_1MIN, TREND_CAPACITY_1H };
+
+// all series of one time bucket
+typedef struct {
+    int64_t index;                  // start time / bucket length, -1 if unused
+    float min[TREND_SERIES];
+    float max[TREND_SERIES];
+    double sum[TREND_SERIES];
+    uint32_t count[TREND_SERIES];
+} trend_bucket;
+
+typedef struct {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t size;                  // size of the complete store
+    uint32_t series;
+    int64_t last_index[TREND_LEVELS];   // newest bucket written, -1 if none
+} trend_header;
+
+typedef struct {
+    trend_header header;
+    trend_bucket level_1s[TREND_CAPACITY_1S];
+    trend_bucket level_1min[TREND_CAPACITY_1MIN];
+    trend_bucket level_1h[TREND_CAPACITY_1H];
+} trend_store;
+
+static trend_store *store = NULL;
+static bool store_mapped = false;
+static trend_bucket *level_base[TREND_LEVELS];
+
+// the store is written by the stream reader and the timer thread
+// and read by the server thread
+static pthread_mutex_t trend_lock = PTHREAD_MUTEX_INITIALIZER;
+
+static void store_init()
+{
+    memset(store, 0, sizeof(trend_store));
+    store->header.magic = TREND_MAGIC;
+    store->header.version = TREND_VERSION;
+    store->header.size = sizeof(trend_store);
+    store->header.series = TREND_SERIES;
+    for (int l=0; l<TREND_LEVELS; l++)
+    {
+        store->header.last_index[l] = -1;
+        for (int i=0; i<level_capacity[l]; i++)
+            level_base[l][i].index = -1;
+    }
+}
+
+void trend_open(const char *path)
+{
+    for (int l=0; l<TREND_LEVELS; l++)
+        for (int s=0; s<TREND_SERIES; s++)
+            for (int k=0; k<TREND_KINDS; k++)
+                trend_select[l][s][k] = (trend_selector){ .level = l, .series = s, .kind = k };
+
+    int fd = open(path, O_RDWR | O_CREAT, 0644);
+    if ((fd != -1) && (ftruncate(fd, sizeof(trend_store)) == 0))
+    {
+        void *p = mmap(NULL, sizeof(trend_store), PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+        if (p != MAP_FAILED)
+        {
+            store = (trend_store *)p;
+            store_mapped = true;
+        }
+    }
+    if (fd != -1) close(fd);
+    if (store == NULL)
+    {
+        printf("OpcUaServer : failed to map %s, trends are not persistent\n", path);
+        store = (trend_store *)calloc(1, sizeof(trend_store));
+        if (store == NULL) return;
+    }
+    level_base[TREND_1S] = store->level_1s;
+    level_base[TREND_1MIN] = store->level_1min;
+    level_base[TREND_1H] = store->level_1h;
+    if ((store->header.magic != TREND_MAGIC) || (store->header.version != TREND_VERSION) ||
+        (store->header.size != sizeof(trend_store)) || (store->header.series != TREND_SERIES))
+    {
+        printf("OpcUaServer : trend store initialized\n");
+        store_init();
+    }
+    else
+        printf("OpcUaServer : trend store %s reopened\n", path);
+}
+
+void trend_close()
+{
+    pthread_mutex_lock(&trend_lock);
+    if (store_mapped)
+    {
+        msync(store, sizeof(trend_store), MS_SYNC);
+        munmap(store, sizeof(trend_store));
+    }
+    else
+        free(store);
+    store = NULL;
+    pthread_mutex_unlock(&trend_lock);
+}
+
+/***********************************/
+/* filling                         */
+/***********************************/
+
+typedef struct {
+    float min;
+    float max;
+    double sum;
+    uint32_t count;
+} trend_aggregate;
+
+// merge the aggregate of one second into all resolutions, trend_lock must be held
+static void merge(int series, int64_t second, const trend_aggregate *a)
+{
+    if ((store == NULL) || (a->count == 0)) return;
+    for (int l=0; l<TREND_LEVELS; l++)
+    {
+        int64_t index = second / level_seconds[l];
+        trend_bucket *b = &level_base[l][index % level_capacity[l]];
+        if (b->index != index)
+        {
+            memset(b, 0, sizeof(trend_bucket));
+            b->index = index;
+        }
+        if (b->count[series] == 0)
+        {
+            b->min[series] = a->min;
+            b->max[series] = a->max;
+        }
+        else
+        {
+            if (a->min < b->min[series]) b->min[series] = a->min;
+            if (a->max > b->max[series]) b->max[series] = a->max;
+        }
+        b->sum[series] += a->sum;
+        b->count[series] += a->count;
+        if (index > store->header.last_index[l])
+            store->header.last_index[l] = index;
+    }
+}
+
+// the second currently collected in the ingest path
+static int64_t partial_second = -1;
+static trend_aggregate partial[PULSE_CHANNELS];
+
+static void flush_partial()
+{
+    if (partial_second >= 0)
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+            merge(ch, partial_second, &partial[ch]);
+    memset(partial, 0, sizeof(partial));
+    partial_second = -1;
+}
+
+void trend_process(const pulse_data *blocks, const pulse_info *info, int count)
+{
+    int k = 0;
+    while (k < count)
+    {
+        // the blocks of the same second
+        int64_t second = info[k].timestamp / 1000000000;
+        int j = k + 1;
+        while ((j < count) && (info[j].timestamp / 1000000000 == second)) j++;
+        trend_aggregate a[PULSE_CHANNELS];
+        for (int ch=0; ch<PULSE_CHANNELS; ch++)
+        {
+            float mn = (float)PULSE_VALUE(&blocks[k], ch, FIELD_AVG);
+            float mx = mn;
+            double sum = 0.0;
+            for (int i=k; i<j; i++)
+            {
+                float v = (float)PULSE_VALUE(&blocks[i], ch, FIELD_AVG);
+                mn = (v < mn) ? v : mn;
+                mx = (v > mx) ? v : mx;
+                sum += v;
+            }
+            a[ch] = (trend_aggregate){ .min = mn, .max = mx, .sum = sum, .count = (uint32_t)(j - k) };
+        }
+        pthread_mutex_lock(&trend_lock);
+        if (second != partial_second)
+        {
+            flush_partial();
+            partial_second = second;
+            for (int ch=0; ch<PULSE_CHANNELS; ch++)
+                partial[ch] = a[ch];
+        }
+        else
+        {
+            for (int ch=0; ch<PULSE_CHANNELS; ch++)
+            {
+                if (a[ch].min < partial[ch].min) partial[ch].min = a[ch].min;
+                if (a[ch].max > partial[ch].max) partial[ch].max = a[ch].max;
+                partial[ch].sum += a[ch].sum;
+                partial[ch].count += a[ch].count;
+            }
+        }
+        pthread_mutex_unlock(&trend_lock);
+        k = j;
+    }
+}
+
+static int seconds_since_sync = 0;
+
+void trend_update(int32_t pps)
+{
+    struct timespec now;
+    clock_gettime(CLOCK_REALTIME, &now);
+    // the pulse count belongs to the second that has just passed
+    int64_t second = (int64_t)now.tv_sec - 1;
+    trend_aggregate a = { .min = (float)pps, .max = (float)pps, .sum = pps, .count = 1 };
+    pthread_mutex_lock(&trend_lock);
+    merge(TREND_PPS, second, &a);
+    // complete the baselines if no further pulse has arrived
+    if ((partial_second >= 0) && (partial_second < second))
+        flush_partial();
+    pthread_mutex_unlock(&trend_lock);
+    if (store_mapped && (++seconds_since_sync >= 60))
+    {
+        msync(store, sizeof(trend_store), MS_ASYNC);
+        seconds_since_sync = 0;
+    }
+}
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+UA_StatusCode read_trend(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue)
+{
+    const trend_selector *sel = (const trend_selector *)nodeContext;
+    if ((sel == NULL) || (store == NULL))
+        return UA_STATUSCODE_BADRESOURCEUNAVAILABLE;
+    int l = sel->level;
+    int s = sel->series;
+    int cap = level_capacity[l];
+    const UA_DataType *type = (sel->kind == TREND_TIME) ? &UA_TYPES[UA_TYPES_DATETIME] :
+                              (sel->kind == TREND_COUNT) ? &UA_TYPES[UA_TYPES_UINT32] : &UA_TYPES[UA_TYPES_FLOAT];
+
+    pthread_mutex_lock(&trend_lock);
+    int64_t last = store->header.last_index[l];
+    size_t n = (last < 0) ? 0 : (size_t)cap;
+    void *data = UA_Array_new(n, type);
+    if ((n > 0) && (data == NULL))
+    {
+        pthread_mutex_unlock(&trend_lock);
+        return UA_STATUSCODE_BADOUTOFMEMORY;
+    }
+    for (size_t i=0; i<n; i++)
+    {
+        int64_t index = last - cap + 1 + (int64_t)i;
+        const trend_bucket *b = &level_base[l][((index % cap) + cap) % cap];
+        uint32_t c = (b->index == index) ? b->count[s] : 0;
+        switch (sel->kind)
+        {
+            case TREND_TIME:
+                ((UA_DateTime *)data)[i] = index * level_seconds[l] * UA_DATETIME_SEC + UA_DATETIME_UNIX_EPOCH;
+                break;
+            case TREND_MEAN:
+                ((UA_Float *)data)[i] = (c > 0) ? (float)(b->sum[s] / c) : NAN;
+                break;
+            case TREND_MIN:
+                ((UA_Float *)data)[i] = (c > 0) ? b->min[s] : NAN;
+                break;
+            case TREND_MAX:
+                ((UA_Float *)data)[i] = (c > 0) ? b->max[s] : NAN;
+                break;
+            default:
+                ((UA_UInt32 *)data)[i] = c;
+                break;
+        }
+    }
+    pthread_mutex_unlock(&trend_lock);
+    UA_Variant_setArray(&dataValue->value, data, n, type);
+    dataValue->hasValue = true;
+    return UA_STATUSCODE_GOOD;
+}
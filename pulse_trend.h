@@ -0,0 +1,117 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_trend.h
+  OpcUaServer : long-term trends of the channel baselines and the pulse rate
+  Version 0.2 2026/10/19
+
+  The trend store keeps min/max/mean/count of Ch1_avg ... Ch4_avg and pps
+  in buckets of 1 s, 1 min and 1 h. Every resolution is a ring of a fixed
+  number of buckets, a slot is reused when its time has passed out of the window:
+    1 s  : 3600 buckets (1 hour)
+    1 min: 1440 buckets (1 day)
+    1 h  : 2160 buckets (90 days)
+  The data of one second are collected in the ingest path and merged into
+  all resolutions when the second is complete.
+
+  The store is kept in a memory-mapped file (TREND_FILE) and survives restarts.
+  The file has a fixed size, a file with a different layout is reinitialized.
+
+  Every bucket array is served as an OPC UA array ordered from the oldest to
+  the newest bucket, empty buckets have a count of 0 and NaN values.
+ */
+
+#include <stdint.h>
+#include <stdbool.h>
+
+#ifndef PULSETREND_H
+#define PULSETREND_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+#define TREND_FILE "/var/tmp/opcua_server_trend.dat"
+
+// resolutions
+#define TREND_LEVELS 3
+#define TREND_1S 0
+#define TREND_1MIN 1
+#define TREND_1H 2
+
+// series : Ch1_avg ... Ch4_avg, pps
+#define TREND_SERIES 5
+#define TREND_PPS 4
+
+// arrays served per series
+#define TREND_KINDS 5
+#define TREND_TIME 0            // start of the bucket (same for all series)
+#define TREND_MEAN 1
+#define TREND_MIN 2
+#define TREND_MAX 3
+#define TREND_COUNT 4
+
+// selects one array, used as node context of the array nodes
+typedef struct {
+    int level;
+    int series;
+    int kind;
+} trend_selector;
+
+extern trend_selector trend_select[TREND_LEVELS][TREND_SERIES][TREND_KINDS];
+
+// map the store file, falls back to memory if the file can not be used
+void trend_open(const char *path);
+
+// unmap the store file
+void trend_close();
+
+// collect the baselines of a batch of data blocks
+void trend_process(const pulse_data *blocks, const pulse_info *info, int count);
+
+// to be called once every second from the timer thread
+// with the number of pulses received within the last second
+void trend_update(int32_t pps);
+
+/***********************************/
+/* OPC-UA data source              */
+/***********************************/
+
+// read one bucket array, nodeContext is a trend_selector
+UA_StatusCode read_trend(
+    UA_Server *server,
+    const UA_NodeId *sessionId, void *sessionContext,
+    const UA_NodeId *nodeId, void *nodeContext,
+    UA_Boolean sourceTimeStamp,
+    const UA_NumericRange *range,
+    UA_DataValue *dataValue);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,205 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_trigger.c
+  OpcUaServer : association of the pulses with the t2 triggers
+  Version 0.2 2026/10/19
+ */
+
+#define _POSIX_C_SOURCE 200809L
+
+#include <stdio.h>
+#include <stdlib.h>
+#include <stdbool.h>
+#include <math.h>
+#include <time.h>
+#include <pthread.h>
+
+#include "libera_mci.h"      // the MCI access layer
+#include "device_clock.h"
+#include "pulse_trigger.h"
+
+/***********************************/
+/* configuration                   */
+/***********************************/
+
+int32_t trigger_poll = 20;
+int32_t trigger_latency = 5000;
+
+/***********************************/
+/* results                         */
+/***********************************/
+
+uint64_t trigger_index = 0;
+double trigger_offset = 0.0;
+double trigger_period = 0.0;
+int32_t trigger_unmatched = 0;
+
+/***********************************/
+/* observed triggers               */
+/***********************************/
+
+typedef struct {
+    uint64_t count;             // t2_count
+    uint64_t time;              // t2_time [device ticks]
+} trigger_observation;
+
+// number of attempts to read a consistent pair of t2_count and t2_time
+#define TRIGGER_RETRIES 3
+
+// written by the poller thread, read by the stream reader thread
+static trigger_observation history[TRIGGER_HISTORY];
+static int history_next = 0;
+static int history_fill = 0;
+static pthread_mutex_t trigger_lock = PTHREAD_MUTEX_INITIALIZER;
+static volatile bool trigger_running = true;
+
+static void observe(uint64_t count, uint64_t time)
+{
+    pthread_mutex_lock(&trigger_lock);
+    if (history_fill > 0)
+    {
+        const trigger_observation *last = &history[(history_next + TRIGGER_HISTORY - 1) % TRIGGER_HISTORY];
+        if ((count <= last->count) || (time <= last->time))
+        {
+            pthread_mutex_unlock(&trigger_lock);
+            return;
+        }
+    }
+    history[history_next].count = count;
+    history[history_next].time = time;
+    history_next = (history_next + 1) % TRIGGER_HISTORY;
+    if (history_fill < TRIGGER_HISTORY) history_fill++;
+    pthread_mutex_unlock(&trigger_lock);
+}
+
+// Read t2_count and t2_time of the same trigger.
+// The pair is discarded if a trigger occurred between the reads.
+static bool read_trigger(uint64_t *count, uint64_t *time)
+{
+    for (int i=0; i<TRIGGER_RETRIES; i++)
+    {
+        uint64_t after;
+        if (!mci_get_t2_count(count) || !mci_get_t2_time(time) || !mci_get_t2_count(&after))
+            return false;
+        if (after == *count) return true;
+    }
+    return false;
+}
+
+void* trigger_thread(void *arg)
+{
+    (void)arg;  // Unused parameter
+    while (trigger_running)
+    {
+        uint64_t count, time;
+        if (read_trigger(&count, &time))
+            observe(count, time);
+        int32_t poll = (trigger_poll > 0) ? trigger_poll : 1;
+        struct timespec ts = { .tv_sec = poll / 1000, .tv_nsec = (long)(poll % 1000) * 1000000 };
+        nanosleep(&ts, NULL);
+    }
+    printf("OpcUaServer : trigger thread exit\n");
+    pthread_exit(NULL);
+}
+
+void trigger_stop()
+{
+    trigger_running = false;
+}
+
+/***********************************/
+/* association                     */
+/***********************************/
+
+// Find the trigger preceding the device time d.
+// Returns false if d is older than all observed triggers.
+static bool associate(const trigger_observation *h, int n, uint64_t d, uint64_t *index, double *offset_ticks, double *period)
+{
+    // h[0] is the oldest, h[n-1] the newest observation
+    int i = n - 1;
+    while ((i >= 0) && (h[i].time > d)) i--;
+    if (i < 0) return false;
+    // the period from the interval containing d, or the last interval
+    double p = 0.0;
+    if (i < n - 1)
+        p = (double)(h[i+1].time - h[i].time) / (double)(h[i+1].count - h[i].count);
+    else if (i > 0)
+        p = (double)(h[i].time - h[i-1].time) / (double)(h[i].count - h[i-1].count);
+    uint64_t k = 0;
+    if (p > 0.0)
+    {
+        k = (uint64_t)floor((double)(d - h[i].time) / p);
+        // do not run beyond the next observed trigger
+        if ((i < n - 1) && (h[i].count + k >= h[i+1].count))
+            k = h[i+1].count - h[i].count - 1;
+    }
+    *index = h[i].count + k;
+    *offset_ticks = (double)(d - h[i].time) - (double)k * p;
+    *period = p;
+    return true;
+}
+
+void trigger_process(pulse_info *info, int count)
+{
+    trigger_observation h[TRIGGER_HISTORY];
+    pthread_mutex_lock(&trigger_lock);
+    int n = history_fill;
+    int start = (history_next + TRIGGER_HISTORY - n) % TRIGGER_HISTORY;
+    for (int i=0; i<n; i++)
+        h[i] = history[(start + i) % TRIGGER_HISTORY];
+    pthread_mutex_unlock(&trigger_lock);
+
+    double latency = 1000.0 * (double)trigger_latency;
+    int unmatched = 0;
+    for (int k=0; k<count; k++)
+    {
+        uint64_t d, index;
+        double offset, period, frequency;
+        // the index is ambiguous if the period does not exceed the ingest latency
+        if ((n > 0) &&
+            clock_utc_to_device(info[k].timestamp, &d, &frequency) &&
+            associate(h, n, d, &index, &offset, &period) &&
+            ((period == 0.0) || (period * 1e9 / frequency > latency)))
+        {
+            double ns_per_tick = 1e9 / frequency;
+            info[k].trigger = index;
+            info[k].trigger_offset = (int64_t)llround(offset * ns_per_tick);
+            info[k].flags |= PULSE_FLAG_TRIGGER;
+            trigger_period = period * ns_per_tick;
+        }
+        else
+        {
+            info[k].trigger = 0;
+            info[k].trigger_offset = 0;
+            unmatched++;
+        }
+    }
+    trigger_unmatched += unmatched;
+    if ((count > 0) && (info[count-1].flags & PULSE_FLAG_TRIGGER))
+    {
+        trigger_index = info[count-1].trigger;
+        trigger_offset = (double)info[count-1].trigger_offset;
+    }
+}
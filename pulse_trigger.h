@@ -0,0 +1,92 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_trigger.h
+  OpcUaServer : association of the pulses with the t2 triggers
+  Version 0.2 2026/10/19
+
+  A poller thread follows t2_count and t2_time over MCI and keeps
+  the last TRIGGER_HISTORY observed triggers. The count is read before
+  and after the time, a pair is only accepted if both counts agree. Every ingested block is
+  converted into device time with the clock model and assigned the index
+  (t2_count) of the last trigger before it and the time offset from that trigger.
+
+  If several triggers occurred between two polls, the missed ones are
+  interpolated assuming a constant trigger period. Blocks newer than the
+  last observed trigger are associated by extrapolation with the last period,
+  for non-periodic triggers they are assigned the last observed trigger.
+  Associated blocks are marked with PULSE_FLAG_TRIGGER.
+  No association is possible before the clock model is locked.
+
+  The stream carries no device time, the ingest time is taken when the block
+  is read from the stream. The offsets are only accurate to the reader latency
+  (typically a few ms) and the error of the clock model. For trigger periods
+  not exceeding trigger_latency the index would be ambiguous, the blocks are
+  left without association and counted in trigger_unmatched.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSETRIGGER_H
+#define PULSETRIGGER_H
+
+#include "pulse_data.h"
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// number of observed triggers kept for the association
+#define TRIGGER_HISTORY 64
+
+//*************************************
+// configuration
+// writable through the OPC UA server
+//*************************************
+
+extern int32_t trigger_poll;            // poll interval of the trigger registers [ms]
+extern int32_t trigger_latency;         // upper bound of the ingest latency [us]
+
+//*************************************
+// results
+//*************************************
+
+extern uint64_t trigger_index;          // trigger of the last associated block
+extern double trigger_offset;           // offset of the last associated block from its trigger [ns]
+extern double trigger_period;           // last measured trigger period [ns]
+extern int32_t trigger_unmatched;       // blocks without association since start
+
+// assign the trigger index and offset to a batch of blocks
+void trigger_process(pulse_info *info, int count);
+
+// thread polling the trigger registers
+// runs until trigger_stop() is called
+void* trigger_thread(void *arg);
+void trigger_stop();
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif
@@ -0,0 +1,145 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_type.c
+  OpcUaServer : structured OPC UA data type of the pulse data
+  Version 0.2 2026/10/19
+ */
+
+#include <stdio.h>
+#include <stdlib.h>
+
+#include "pulse_type.h"
+#include "pulse_snapshot.h"
+#include "pulse_push.h"
+
+/***********************************/
+/* data type description           */
+/***********************************/
+
+#define PULSE_MEMBER(name) { .memberName = name, .memberType = &UA_TYPES[UA_TYPES_INT32], .padding = 0, .isArray = false, .isOptional = false }
+#define PULSE_INFO_MEMBER(name, type) { .memberName = name, .memberType = &UA_TYPES[type], .padding = 0, .isArray = false, .isOptional = false }
+
+// the members in the order of pulse_record, there is no padding between them
+#define PULSE_MEMBERS (4+PULSE_CHANNELS*PULSE_FIELDS)
+
+static UA_DataTypeMember pulse_members[PULSE_MEMBERS] = {
+    PULSE_INFO_MEMBER("Sequence", UA_TYPES_UINT64),
+    PULSE_INFO_MEMBER("Trigger", UA_TYPES_UINT64),
+    PULSE_INFO_MEMBER("TriggerOffset", UA_TYPES_INT64),
+    PULSE_INFO_MEMBER("Flags", UA_TYPES_UINT32),
+    PULSE_MEMBER("Ch1_rss"), PULSE_MEMBER("Ch1_peak"), PULSE_MEMBER("Ch1_avg"), PULSE_MEMBER("Ch1_sum"),
+    PULSE_MEMBER("Ch2_rss"), PULSE_MEMBER("Ch2_peak"), PULSE_MEMBER("Ch2_avg"), PULSE_MEMBER("Ch2_sum"),
+    PULSE_MEMBER("Ch3_rss"), PULSE_MEMBER("Ch3_peak"), PULSE_MEMBER("Ch3_avg"), PULSE_MEMBER("Ch3_sum"),
+    PULSE_MEMBER("Ch4_rss"), PULSE_MEMBER("Ch4_peak"), PULSE_MEMBER("Ch4_avg"), PULSE_MEMBER("Ch4_sum") };
+
+UA_DataType PulseDataType = {
+    .typeName = "PulseData",
+    .typeId = { 1, UA_NODEIDTYPE_NUMERIC, { PULSE_TYPE_ID } },
+    .binaryEncodingId = { 1, UA_NODEIDTYPE_NUMERIC, { PULSE_TYPE_ENCODING_ID } },
+    .memSize = sizeof(pulse_record),
+    .typeKind = UA_DATATYPEKIND_STRUCTURE,
+    .pointerFree = true,
+    // pulse_record has trailing padding
+    .overlayable = false,
+    .membersSize = PULSE_MEMBERS,
+    .members = pulse_members };
+
+UA_DataTypeArray pulse_types = {
+    .next = NULL,
+    .typesSize = 1,
+    .types = &PulseDataType,
+    .cleanup = false };
+
+/***********************************/
+/* address space                   */
+/***********************************/
+
+UA_StatusCode pulse_type_add(UA_Server *server, UA_NodeId parent)
+{
+    // the data type below Structure
+    UA_DataTypeAttributes type_attr = UA_DataTypeAttributes_default;
+    type_attr.displayName = UA_LOCALIZEDTEXT("en_US", "PulseData");
+    type_attr.description = UA_LOCALIZEDTEXT("en_US", "one pulse, sequence number, trigger, flags and 4 channels with rss, peak, avg and sum");
+    UA_StatusCode retval = UA_Server_addDataTypeNode(
+            server,
+            PulseDataType.typeId,
+            UA_NS0ID(STRUCTURE),
+            UA_NS0ID(HASSUBTYPE),
+            UA_QUALIFIEDNAME(1, "PulseData"),
+            type_attr,
+            NULL,
+            NULL);
+
+    // the binary encoding, referenced from the data type
+    if (retval == UA_STATUSCODE_GOOD)
+    {
+        UA_ObjectAttributes enc_attr = UA_ObjectAttributes_default;
+        enc_attr.displayName = UA_LOCALIZEDTEXT("en_US", "Default Binary");
+        retval = UA_Server_addObjectNode(
+                server,
+                PulseDataType.binaryEncodingId,
+                UA_NODEID_NULL,
+                UA_NODEID_NULL,
+                UA_QUALIFIEDNAME(0, "Default Binary"),
+                UA_NS0ID(DATATYPEENCODINGTYPE),
+                enc_attr,
+                NULL,
+                NULL);
+    }
+    if (retval == UA_STATUSCODE_GOOD)
+        retval = UA_Server_addReference(
+                server,
+                PulseDataType.typeId,
+                UA_NS0ID(HASENCODING),
+                UA_EXPANDEDNODEID_NUMERIC(1, PULSE_TYPE_ENCODING_ID),
+                true);
+
+    // the variable with the last data block, updated by the push callback
+    if (retval == UA_STATUSCODE_GOOD)
+    {
+        UA_VariableAttributes attr = UA_VariableAttributes_default;
+        UA_Variant_setScalar(&attr.value, &stream_snapshot.pulse, &PulseDataType);
+        attr.dataType = PulseDataType.typeId;
+        attr.description = UA_LOCALIZEDTEXT("en_US", "complete data block of the last pulse");
+        attr.displayName = UA_LOCALIZEDTEXT("en_US", "Pulse");
+        attr.valueRank = UA_VALUERANK_SCALAR;
+        attr.accessLevel = UA_ACCESSLEVELMASK_READ;
+        retval = UA_Server_addVariableNode(
+                server,
+                UA_NODEID_STRING(1, "Pulse"),
+                parent,
+                UA_NS0ID(ORGANIZES),
+                UA_QUALIFIEDNAME(1, "Pulse"),
+                UA_NS0ID(BASEDATAVARIABLETYPE),
+                attr,
+                NULL,
+                NULL);
+    }
+    if (retval == UA_STATUSCODE_GOOD)
+        push_register(UA_NODEID_STRING(1, "Pulse"), &stream_snapshot.pulse, &PulseDataType);
+    if (retval != UA_STATUSCODE_GOOD)
+        printf("OpcUaServer : failed to add the PulseData type %8x\n", retval);
+    return retval;
+}
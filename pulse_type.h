@@ -0,0 +1,72 @@
+/*
+MIT License
+
+Copyright (c) 2025 Ulf Lehnert, Helmholtz-Center Dresden-Rossendorf
+
+Permission is hereby granted, free of charge, to any person obtaining a copy
+of this software and associated documentation files (the "Software"), to deal
+in the Software without restriction, including without limitation the rights
+to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+copies of the Software, and to permit persons to whom the Software is
+furnished to do so, subject to the following conditions:
+
+The above copyright notice and this permission notice shall be included in all
+copies or substantial portions of the Software.
+
+THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+SOFTWARE.
+*/
+
+/** @file pulse_type.h
+  OpcUaServer : structured OPC UA data type of the pulse data
+  Version 0.2 2026/10/19
+
+  The data type PulseData has the members Sequence, Trigger, TriggerOffset,
+  Flags and the 16 Int32 members Ch1_rss ... Ch4_sum in the order of
+  pulse_data, with the memory layout of pulse_record (pulse_snapshot.h).
+  It is registered as a custom data type of the server and added to the
+  address space with its binary encoding, so generic clients can decode it
+  from the DataTypeDefinition.
+
+  The variable Pulse holds the complete last data block as one value.
+  It is a push variable (pulse_push.h), written with every pushed block,
+  in the lossless mode with every accepted block. As the sequence number
+  differs for every block, a monitored item with the default data change
+  trigger (STATUS_VALUE) is notified of every write, all members of one
+  notification always belong to the same block.
+ */
+
+#include <stdint.h>
+
+#ifndef PULSETYPE_H
+#define PULSETYPE_H
+
+#include "pulse_data.h"
+#include "open62541.h"       // the OPC UA library
+
+#ifdef __cplusplus
+extern "C" {
+#endif
+
+// node ids of the data type and its encoding in namespace 1
+#define PULSE_TYPE_ID 4001
+#define PULSE_TYPE_ENCODING_ID 4002
+
+// description of the data type, to be set as customDataTypes of the server configuration
+extern UA_DataType PulseDataType;
+extern UA_DataTypeArray pulse_types;
+
+// add the data type nodes and the variable Pulse to the given folder
+// and register the variable for the push updates
+UA_StatusCode pulse_type_add(UA_Server *server, UA_NodeId parent);
+
+#ifdef __cplusplus
+} // extern "C"
+#endif
+
+#endif